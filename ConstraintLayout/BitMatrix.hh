@@ -0,0 +1,204 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BITWORDS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITWORDS_SSE2
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Word-level operations over packed 64-bit bit rows
+struct BitWords
+{
+	typedef std::uint64_t	WordType;
+	static constexpr std::size_t WordBits = 64;
+
+	static inline std::size_t WordsFor(std::size_t bits) { return (bits + WordBits - 1) / WordBits; }
+
+	static inline void Set(WordType * row, std::size_t idx)
+	{
+		row[idx / WordBits] |= WordType(1) << (idx % WordBits);
+	}
+	static inline void Reset(WordType * row, std::size_t idx)
+	{
+		row[idx / WordBits] &= ~(WordType(1) << (idx % WordBits));
+	}
+	static inline bool Test(const WordType * row, std::size_t idx)
+	{
+		return (row[idx / WordBits] >> (idx % WordBits)) & 1;
+	}
+
+	static inline std::size_t PopCount(WordType word)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return (std::size_t)__popcnt64(word);
+#elif defined(_MSC_VER)
+		return (std::size_t)(__popcnt((unsigned)word) + __popcnt((unsigned)(word >> 32)));
+#else
+		return (std::size_t)__builtin_popcountll(word);
+#endif
+	}
+
+	// Bits needed to represent word; 0 for 0
+	static inline std::size_t BitWidth(WordType word)
+	{
+		if (word == 0)
+			return 0;
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long idx; _BitScanReverse64(&idx, word);
+		return idx + 1;
+#elif defined(_MSC_VER)
+		unsigned long idx;
+		if (_BitScanReverse(&idx, (unsigned long)(word >> 32)))
+			return idx + 33;
+		_BitScanReverse(&idx, (unsigned long)word);
+		return idx + 1;
+#else
+		return WordBits - (std::size_t)__builtin_clzll(word);
+#endif
+	}
+
+	static inline std::size_t CountTrailingZeros(WordType word)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long idx; _BitScanForward64(&idx, word);
+		return idx;
+#elif defined(_MSC_VER)
+		unsigned long idx;
+		if (_BitScanForward(&idx, (unsigned long)word))
+			return idx;
+		_BitScanForward(&idx, (unsigned long)(word >> 32));
+		return idx + 32;
+#else
+		return (std::size_t)__builtin_ctzll(word);
+#endif
+	}
+
+	// dst |= src
+	static inline void Or(WordType * dst, const WordType * src, std::size_t words)
+	{
+		std::size_t i = 0;
+#if defined(BITWORDS_AVX2)
+		for (; i + 4 <= words; i += 4)
+		{
+			__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+			__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(d, s));
+		}
+#endif
+#if defined(BITWORDS_SSE2)
+		for (; i + 2 <= words; i += 2)
+		{
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+			__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(d, s));
+		}
+#endif
+		for (; i < words; i++)
+			dst[i] |= src[i];
+	}
+
+	// dst &= ~src
+	static inline void AndNot(WordType * dst, const WordType * src, std::size_t words)
+	{
+		std::size_t i = 0;
+#if defined(BITWORDS_AVX2)
+		for (; i + 4 <= words; i += 4)
+		{
+			__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+			__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_andnot_si256(s, d));
+		}
+#endif
+#if defined(BITWORDS_SSE2)
+		for (; i + 2 <= words; i += 2)
+		{
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+			__m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_andnot_si128(s, d));
+		}
+#endif
+		for (; i < words; i++)
+			dst[i] &= ~src[i];
+	}
+
+	static inline std::size_t Count(const WordType * row, std::size_t words)
+	{
+		std::size_t rtn = 0;
+		for (std::size_t i = 0; i < words; i++)
+			rtn += PopCount(row[i]);
+		return rtn;
+	}
+
+	static inline bool Any(const WordType * row, std::size_t words)
+	{
+		for (std::size_t i = 0; i < words; i++)
+			if (row[i])
+				return true;
+		return false;
+	}
+
+	// Calls func(idx) for every set bit in ascending order
+	template<class Func>
+	static inline void ForEach(const WordType * row, std::size_t words, Func && func)
+	{
+		for (std::size_t i = 0; i < words; i++)
+		{
+			WordType word = row[i];
+			while (word)
+			{
+				func(i * WordBits + CountTrailingZeros(word));
+				word &= word - 1;
+			}
+		}
+	}
+};
+
+// Dense rows x cols bit matrix stored as contiguous 64-bit words
+class BitMatrix
+{
+public:
+	typedef BitWords::WordType	WordType;
+
+protected:
+	std::size_t				_rows;
+	std::size_t				_cols;
+	std::size_t				_stride;
+	std::vector<WordType>	_words;
+
+public:
+	BitMatrix()
+		: _rows(0), _cols(0), _stride(0)
+	{ }
+
+	BitMatrix(std::size_t rows, std::size_t cols)
+		: _rows(rows), _cols(cols), _stride(BitWords::WordsFor(cols)),
+		_words(rows * BitWords::WordsFor(cols))
+	{ }
+
+	inline std::size_t Rows() const { return _rows; }
+	inline std::size_t Cols() const { return _cols; }
+	inline std::size_t Stride() const { return _stride; }
+
+	inline WordType * Row(std::size_t row) { return _words.data() + row * _stride; }
+	inline const WordType * Row(std::size_t row) const { return _words.data() + row * _stride; }
+
+	inline void Set(std::size_t row, std::size_t col) { BitWords::Set(Row(row), col); }
+	inline void Reset(std::size_t row, std::size_t col) { BitWords::Reset(Row(row), col); }
+	inline bool Test(std::size_t row, std::size_t col) const { return BitWords::Test(Row(row), col); }
+
+	// row(dst) |= row(src)
+	inline void OrRow(std::size_t dst, std::size_t src) { BitWords::Or(Row(dst), Row(src), _stride); }
+	inline std::size_t CountRow(std::size_t row) const { return BitWords::Count(Row(row), _stride); }
+
+	inline void Clear() { std::fill(_words.begin(), _words.end(), WordType(0)); }
+};
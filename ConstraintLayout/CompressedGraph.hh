@@ -0,0 +1,451 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include "GraphTraits.hh"
+
+// The shuffle decode is built on every x86 target. Unless the compiler may
+// assume SSSE3, it is compiled for SSSE3 alone and picked by CPUID at run time.
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define STREAMVBYTE_SSSE3
+#define STREAMVBYTE_TARGET
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define STREAMVBYTE_SSSE3
+#define STREAMVBYTE_DISPATCH
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <tmmintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#define STREAMVBYTE_TARGET
+#else
+#define STREAMVBYTE_TARGET __attribute__((target("ssse3")))
+#endif
+#endif
+
+// LEB128 varints with zigzag mapping for signed values
+struct VarInt
+{
+	static inline void Encode(std::uint64_t value, std::vector<std::uint8_t> & out)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((std::uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((std::uint8_t)value);
+	}
+
+	static inline std::uint64_t Decode(const std::uint8_t *& data)
+	{
+		std::uint64_t rtn = 0;
+		for (unsigned shift = 0;; shift += 7)
+		{
+			std::uint8_t byte = *data++;
+			rtn |= (std::uint64_t)(byte & 0x7F) << shift;
+			if (byte < 0x80)
+				return rtn;
+		}
+	}
+
+	static inline std::uint64_t ZigZag(std::int64_t value)
+	{
+		return ((std::uint64_t)value << 1) ^ (std::uint64_t)(value >> 63);
+	}
+	static inline std::int64_t UnZigZag(std::uint64_t value)
+	{
+		return (std::int64_t)(value >> 1) ^ -(std::int64_t)(value & 1);
+	}
+};
+
+// Stream VByte coding of 32-bit integers: one 2-bit length code per value,
+// packed four to a control byte, followed by the 1-4 data bytes of each value.
+// Keeping the lengths apart from the data lets a whole control byte drive a
+// single shuffle that decodes four values. Decoding may read up to Padding
+// bytes past the end of the data.
+struct StreamVByte
+{
+	static constexpr std::size_t Padding = 16;
+
+	static inline std::size_t ControlBytes(std::size_t count) { return (count + 3) / 4; }
+
+	static inline unsigned Code(std::uint32_t value)
+	{
+		return value < (1u << 8) ? 0 : value < (1u << 16) ? 1 : value < (1u << 24) ? 2 : 3;
+	}
+
+	// Appends the control bytes then the data bytes; returns the data size
+	static std::size_t Encode(const std::uint32_t * values, std::size_t count, std::vector<std::uint8_t> & out)
+	{
+		std::size_t control = out.size();
+		out.resize(control + ControlBytes(count));
+		std::size_t data = out.size();
+		for (std::size_t i = 0; i < count; i++)
+		{
+			unsigned code = Code(values[i]);
+			out[control + i / 4] |= (std::uint8_t)(code << (2 * (i % 4)));
+			for (unsigned b = 0; b <= code; b++)
+				out.push_back((std::uint8_t)(values[i] >> (8 * b)));
+		}
+		return out.size() - data;
+	}
+
+	static inline unsigned CodeAt(const std::uint8_t * control, std::size_t idx)
+	{
+		return (control[idx / 4] >> (2 * (idx % 4))) & 3;
+	}
+
+	static inline std::uint32_t DecodeOne(unsigned code, const std::uint8_t *& data)
+	{
+		std::uint32_t rtn = data[0];
+		if (code >= 1) rtn |= (std::uint32_t)data[1] << 8;
+		if (code >= 2) rtn |= (std::uint32_t)data[2] << 16;
+		if (code == 3) rtn |= (std::uint32_t)data[3] << 24;
+		data += code + 1;
+		return rtn;
+	}
+
+	// Decodes count gaps and writes their running sum, starting from base
+	static void DecodeDelta(const std::uint8_t * control, const std::uint8_t * data, std::size_t count,
+		std::uint32_t base, std::uint32_t * out)
+	{
+		std::size_t i = 0;
+#if defined(STREAMVBYTE_SSSE3)
+		if (HasSsse3())
+		{
+			i = _DecodeDeltaSsse3(control, data, count, base, out);
+			if (i)
+				base = out[i - 1];
+		}
+#endif
+		for (; i < count; i++)
+		{
+			base += DecodeOne(CodeAt(control, i), data);
+			out[i] = base;
+		}
+	}
+
+	// Whether DecodeDelta takes the shuffle path
+	static inline bool HasSsse3()
+	{
+#if !defined(STREAMVBYTE_SSSE3)
+		return false;
+#elif !defined(STREAMVBYTE_DISPATCH)
+		return true;
+#elif defined(_MSC_VER)
+		static const bool rtn = []()
+		{
+			int info[4];
+			__cpuid(info, 1);
+			return (info[2] & (1 << 9)) != 0;
+		}();
+		return rtn;
+#else
+		static const bool rtn = __builtin_cpu_supports("ssse3");
+		return rtn;
+#endif
+	}
+
+protected:
+	struct _Tables
+	{
+		std::uint8_t shuffle[256][16];
+		std::uint8_t length[256];
+	};
+
+#if defined(STREAMVBYTE_SSSE3)
+	// Decodes whole groups of four and advances data past them; returns how many values were written
+	STREAMVBYTE_TARGET static std::size_t _DecodeDeltaSsse3(const std::uint8_t * control, const std::uint8_t *& data,
+		std::size_t count, std::uint32_t base, std::uint32_t * out)
+	{
+		const _Tables & tables = _GetTables();
+		__m128i prev = _mm_set1_epi32((int)base);
+		std::size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			std::uint8_t key = control[i / 4];
+			__m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data),
+				_mm_loadu_si128((const __m128i *)tables.shuffle[key]));
+			v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+			v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+			v = _mm_add_epi32(v, prev);
+			_mm_storeu_si128((__m128i *)(out + i), v);
+			prev = _mm_shuffle_epi32(v, 0xFF);
+			data += tables.length[key];
+		}
+		return i;
+	}
+#endif
+
+	static const _Tables & _GetTables()
+	{
+		static const _Tables tables = []()
+		{
+			_Tables rtn;
+			for (unsigned key = 0; key < 256; key++)
+			{
+				std::uint8_t src = 0;
+				for (unsigned i = 0; i < 4; i++)
+				{
+					unsigned size = ((key >> (2 * i)) & 3) + 1;
+					for (unsigned b = 0; b < 4; b++)
+						rtn.shuffle[key][4 * i + b] = b < size ? src++ : 0xFF;
+				}
+				rtn.length[key] = src;
+			}
+			return rtn;
+		}();
+		return tables;
+	}
+};
+
+// Read-only graph with each adjacency list sorted by destination, destinations
+// stored as Stream VByte gaps and weights as zigzag varints. Per vertex:
+//		varint degree, varint gap data size, gap control bytes, gap data, weights
+// Edges take about 2.5-4 bytes, depending on locality and weight range.
+// EdgesFrom decodes lazily, one scalar value at a time, so the generic
+// algorithms in GraphAlgorithm.hh (Dijkstra, strongly connected groups...)
+// run on it directly but never take the SIMD path; only DestinationsFrom,
+// DecodeFrom and the traversals below decode in bulk.
+// Vertex ids must fit in 32 bits; the constructor throws std::out_of_range otherwise.
+template<
+	class SizeType = std::size_t,
+	class WeightType = std::ptrdiff_t
+>
+class CompressedGraph
+{
+public:
+	typedef SizeType	IndexType;
+	typedef WeightType	DistanceType;
+
+	struct Edge
+	{
+		SizeType destination;
+		WeightType weight;
+	};
+
+	class EdgeIterator
+	{
+	protected:
+		const std::uint8_t *	_control;
+		const std::uint8_t *	_data;
+		const std::uint8_t *	_weights;
+		SizeType				_index;
+		SizeType				_size;
+		Edge					_edge;
+
+		inline void _Load()
+		{
+			if (_index < _size)
+			{
+				_edge.destination += (SizeType)StreamVByte::DecodeOne(StreamVByte::CodeAt(_control, _index), _data);
+				_edge.weight = (WeightType)VarInt::UnZigZag(VarInt::Decode(_weights));
+			}
+		}
+
+	public:
+		typedef std::input_iterator_tag	iterator_category;
+		typedef Edge					value_type;
+		typedef std::ptrdiff_t			difference_type;
+		typedef const Edge *			pointer;
+		typedef const Edge &			reference;
+
+		EdgeIterator(const std::uint8_t * control, const std::uint8_t * data, const std::uint8_t * weights,
+			SizeType index, SizeType size)
+			: _control(control), _data(data), _weights(weights), _index(index), _size(size), _edge{ 0, 0 }
+		{
+			_Load();
+		}
+
+		inline reference operator* () const { return _edge; }
+		inline pointer operator-> () const { return &_edge; }
+		inline EdgeIterator & operator++ ()
+		{
+			_index++;
+			_Load();
+			return *this;
+		}
+		inline EdgeIterator operator++ (int)
+		{
+			EdgeIterator rtn = *this;
+			++*this;
+			return rtn;
+		}
+		inline bool operator== (const EdgeIterator & other) const { return _index == other._index; }
+		inline bool operator!= (const EdgeIterator & other) const { return _index != other._index; }
+	};
+
+	class EdgeRange
+	{
+	protected:
+		const std::uint8_t *	_control;
+		const std::uint8_t *	_data;
+		const std::uint8_t *	_weights;
+		SizeType				_size;
+
+	public:
+		EdgeRange(const std::uint8_t * list)
+		{
+			_size = (SizeType)VarInt::Decode(list);
+			std::size_t dataSize = (std::size_t)VarInt::Decode(list);
+			_control = list;
+			_data = _control + StreamVByte::ControlBytes(_size);
+			_weights = _data + dataSize;
+		}
+		inline EdgeIterator begin() const { return EdgeIterator(_control, _data, _weights, 0, _size); }
+		inline EdgeIterator end() const { return EdgeIterator(_control, _data, _weights, _size, _size); }
+		inline SizeType size() const { return _size; }
+		inline bool empty() const { return _size == 0; }
+		inline const std::uint8_t * Control() const { return _control; }
+		inline const std::uint8_t * Data() const { return _data; }
+		inline const std::uint8_t * Weights() const { return _weights; }
+	};
+
+	static constexpr SizeType InvalidVertex	= std::numeric_limits<SizeType>::max();
+	static constexpr WeightType Infinity	= std::numeric_limits<WeightType>::max();
+
+protected:
+	std::vector<std::uint64_t>	_offsets;
+	std::vector<std::uint8_t>	_bytes;
+	SizeType					_edgesSize;
+
+	void _Encode(std::vector<Edge> & edges)
+	{
+		std::sort(edges.begin(), edges.end(), [](const Edge & l, const Edge & r)
+		{
+			return l.destination < r.destination || (l.destination == r.destination && l.weight < r.weight);
+		});
+		// Gaps are encoded as 32-bit words, so larger ids are rejected rather than truncated
+		if (!edges.empty() && (std::uint64_t)edges.back().destination > std::numeric_limits<std::uint32_t>::max())
+			throw std::out_of_range("CompressedGraph: vertex id does not fit in 32 bits");
+		std::vector<std::uint32_t> gaps(edges.size());
+		for (std::size_t i = 0; i < edges.size(); i++)
+			gaps[i] = (std::uint32_t)(edges[i].destination - (i ? edges[i - 1].destination : 0));
+
+		std::vector<std::uint8_t> data;
+		std::size_t dataSize = StreamVByte::Encode(gaps.data(), gaps.size(), data);
+		VarInt::Encode(edges.size(), _bytes);
+		VarInt::Encode(dataSize, _bytes);
+		_bytes.insert(_bytes.end(), data.begin(), data.end());
+		for (auto & edge : edges)
+			VarInt::Encode(VarInt::ZigZag((std::int64_t)edge.weight), _bytes);
+		_edgesSize += (SizeType)edges.size();
+	}
+
+	void _Finish()
+	{
+		_offsets.push_back(_bytes.size());
+		_bytes.resize(_bytes.size() + StreamVByte::Padding);
+		_bytes.shrink_to_fit();
+	}
+
+public:
+	CompressedGraph()
+		: _offsets(1, 0), _bytes(StreamVByte::Padding), _edgesSize(0)
+	{ }
+
+	// Compresses any graph that models the graph concept
+	template<class Graph, class = typename std::enable_if<IsGraph<Graph>::value>::type>
+	explicit CompressedGraph(const Graph & graph)
+		: _edgesSize(0)
+	{
+		typedef GraphTraits<Graph> Traits;
+		SizeType size = (SizeType)Traits::VerticesSize(graph);
+		_offsets.reserve(size + 1);
+		std::vector<Edge> edges;
+		for (SizeType v = 0; v < size; v++)
+		{
+			_offsets.push_back(_bytes.size());
+			edges.clear();
+			for (auto & i : Traits::EdgesFrom(graph, v))
+				edges.push_back({ (SizeType)Traits::Destination(i), (WeightType)Traits::Weight(i) });
+			_Encode(edges);
+		}
+		_Finish();
+	}
+
+	inline SizeType VerticesSize() const { return (SizeType)_offsets.size() - 1; }
+	inline bool VerticesEmpty() const { return VerticesSize() == 0; }
+	inline SizeType EdgesSize() const { return _edgesSize; }
+	inline bool EdgesEmpty() const { return _edgesSize == 0; }
+	inline std::size_t BytesSize() const { return _bytes.size() + _offsets.size() * sizeof(std::uint64_t); }
+
+	inline EdgeRange EdgesFrom(SizeType idx) const { return EdgeRange(_bytes.data() + _offsets[idx]); }
+	inline SizeType OutDegree(SizeType idx) const { return EdgesFrom(idx).size(); }
+
+	// Bulk decode of the destinations of idx; returns the out-degree
+	SizeType DestinationsFrom(SizeType idx, std::vector<std::uint32_t> & out) const
+	{
+		EdgeRange range = EdgesFrom(idx);
+		out.resize(range.size());
+		StreamVByte::DecodeDelta(range.Control(), range.Data(), range.size(), 0, out.data());
+		return range.size();
+	}
+
+	// Bulk decode of the out-edges of idx
+	void DecodeFrom(SizeType idx, std::vector<Edge> & out) const
+	{
+		std::vector<std::uint32_t> destinations;
+		SizeType size = DestinationsFrom(idx, destinations);
+		const std::uint8_t * weights = EdgesFrom(idx).Weights();
+		out.resize(size);
+		for (SizeType i = 0; i < size; i++)
+			out[i] = { (SizeType)destinations[i], (WeightType)VarInt::UnZigZag(VarInt::Decode(weights)) };
+	}
+
+	std::vector<SizeType> BreadthFirstDepths(SizeType source) const
+	{
+		std::vector<SizeType> rtn(VerticesSize(), InvalidVertex);
+		std::vector<SizeType> frontier, next;
+		std::vector<std::uint32_t> destinations;
+		rtn[source] = 0;
+		frontier.push_back(source);
+		for (SizeType depth = 1; !frontier.empty(); depth++)
+		{
+			next.clear();
+			for (auto v : frontier)
+			{
+				DestinationsFrom(v, destinations);
+				for (auto i : destinations)
+				{
+					if (rtn[i] == InvalidVertex)
+					{
+						rtn[i] = depth;
+						next.push_back((SizeType)i);
+					}
+				}
+			}
+			std::swap(frontier, next);
+		}
+		return rtn;
+	}
+
+	bool Reaches(SizeType source, SizeType target) const
+	{
+		std::vector<bool> visited(VerticesSize());
+		std::vector<SizeType> stack(1, source);
+		std::vector<std::uint32_t> destinations;
+		visited[source] = true;
+		while (!stack.empty())
+		{
+			SizeType v = stack.back(); stack.pop_back();
+			if (v == target)
+				return true;
+			DestinationsFrom(v, destinations);
+			for (auto i : destinations)
+			{
+				if (!visited[i])
+				{
+					visited[i] = true;
+					stack.push_back((SizeType)i);
+				}
+			}
+		}
+		return false;
+	}
+};
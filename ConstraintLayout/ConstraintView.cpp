@@ -1,7 +1,7 @@
 #include "stdafx.h"
 #include "ConstraintView.h"
 
-size_t const ConstraintView::_idx_nan	= std::numeric_limits<size_t>::max();
+ElementIndex const ConstraintView::_idx_nan	= std::numeric_limits<ElementIndex>::max();
 float const ConstraintView::_nan		= std::numeric_limits<float>::quiet_NaN();
 
 ConstraintView::ConstraintView()
@@ -54,87 +54,21 @@ bool ConstraintView::OnUpdate()
 {
 	_InitializeElements();
 
-	static auto const valueByConstraint = [this](const ConstraintViewElement::Constraint & constraint) -> float
+	// Components never reference each other, so they are solved independently
+	if (_components.size() == 1)
 	{
+		for (auto i : _components.front())
+			_SolveElement(i);
+		return true;
+	}
 
-		// If the constraint targets to the edge of the screen
-		if (constraint.target == _idx_nan - 1)
-			return 0;
-		else if (constraint.target == _idx_nan - 2)
-			return (float)_width;
-		else if (constraint.target == _idx_nan - 3)
-			return 0;
-		else if (constraint.target == _idx_nan - 4)
-			return (float)_height;
-
-
-		if (constraint.target >= _elementDependencies.VerticesSize())
-			return _nan;
-
-		auto & target = _elementDependencies.VertexAt(constraint.target).value;
-		switch (constraint.targetDirection)
-		{
-		case DIRECTION_LEFT:
-			return target.x;
-		case DIRECTION_RIGHT:
-			return target.x + target.width;
-		case DIRECTION_TOP:
-			return target.y;
-		case DIRECTION_BOTTOM:
-			return target.y + target.height;
-		}
-		return _nan;
-	};
-
-	for (auto i : _topologicalSort)
-	{
-		auto & elem = _elementDependencies.VertexAt(i).value;
-		auto left	= valueByConstraint(elem.constraint[0]) + elem.constraint[0].value;
-		auto right	= valueByConstraint(elem.constraint[1]) - elem.constraint[1].value;
-		auto top	= valueByConstraint(elem.constraint[2]) + elem.constraint[2].value;
-		auto bottom	= valueByConstraint(elem.constraint[3]) - elem.constraint[3].value;
-
-		float x, y, width, height;
-
-		// horizontal
-		if (isnan(left))
-		{
-			if (isnan(right))
-				x = 0, width = 0;
-			else
-				x = right - elem.elem.width, width = elem.elem.width;
-		}
-		else
-		{
-			if (isnan(right))
-				x = left, width = elem.elem.width;
-			else if (elem.elem.width != 0)
-				x = (right + left - elem.elem.width) / 2.0f, width = elem.elem.width;
-			else
-				x = left, width = right - left;
-		}
-
-		// vertical
-		if (isnan(top))
+	for (auto & component : _components)
+		_pool.Submit([this, &component]
 		{
-			if (isnan(bottom))
-				y = 0, height = 0;
-			else
-				y = bottom - elem.elem.height, height = elem.elem.height;
-		}
-		else
-		{
-			if (isnan(bottom))
-				y = top, height = elem.elem.height;
-			else if (elem.elem.height != 0)
-				y = (bottom + top - elem.elem.height) / 2.0f, height = elem.elem.height;
-			else
-				y = top, height = bottom - top;
-		}
-
-		elem.x = x, elem.y = y;
-		elem.width = width, elem.height = height;
-	}
+			for (auto i : component)
+				_SolveElement(i);
+		});
+	_pool.Wait();
 	return true;
 }
 
@@ -143,9 +77,9 @@ bool ConstraintView::OnRender()
 	_pRT->BeginDraw();
 	_pRT->Clear(D2D1::ColorF(0.0f, 0.2f, 0.4f));
 
-	for (auto & elem : _elementDependencies)
+	for (auto i : _drawOrder)
 	{
-		auto & value = elem.value;
+		auto & value = _elementDependencies.VertexAt(i).value;
 		_pBrush->SetColor(
 			D2D1::ColorF(
 				value.elem.r,
@@ -181,17 +115,23 @@ void ConstraintView::OnDestroy()
 
 bool ConstraintView::_AddElement(
 	const ViewElement & elem,
-	std::string name,
-	std::vector<_AddElementArg> dependency)
+	const std::string & name,
+	const std::vector<_AddElementArg> & dependency)
 {
-
+	// A repeated name replaces the earlier definition in place
+	ElementIndex new_idx = _elementDependencies.VerticesSize();
 	if (auto it = _name_map.find(name); it != _name_map.end())
-		return false;
-
+	{
+		if (it->second >= _idx_nan - 4)
+			return false;
+		new_idx = it->second;
+		_pending.erase(std::remove_if(_pending.begin(), _pending.end(),
+			[new_idx](const _PendingTarget & pending) { return pending.element == new_idx; }), _pending.end());
+	}
 
 	ConstraintViewElement new_elem(elem, name);
 
-	// Find the indices of targets
+	// Find the indices of targets; names not read yet are resolved after the file
 	for (int i = 0; i < 4 && (size_t)i < dependency.size(); i++)
 	{
 		if (dependency.at(i).name.empty())
@@ -199,15 +139,19 @@ bool ConstraintView::_AddElement(
 			new_elem.constraint[i].target = _idx_nan;
 			new_elem.constraint[i].targetDirection = DIRECTION_UNKNOWN;
 			new_elem.constraint[i].value = 0;
+			continue;
 		}
-		else if (auto it = _name_map.find(dependency.at(i).name); it != _name_map.end())
-		{
+		if (dependency.at(i).name == name)
+			return false;
+		if (auto it = _name_map.find(dependency.at(i).name); it != _name_map.end())
 			new_elem.constraint[i].target = it->second;
-			new_elem.constraint[i].targetDirection = dependency.at(i).direction;
-			new_elem.constraint[i].value = dependency.at(i).value;
-		}
 		else
-			return false;
+		{
+			new_elem.constraint[i].target = _idx_nan;
+			_pending.push_back({ dependency.at(i).name, new_idx, i });
+		}
+		new_elem.constraint[i].targetDirection = dependency.at(i).direction;
+		new_elem.constraint[i].value = dependency.at(i).value;
 	}
 
 
@@ -218,16 +162,13 @@ bool ConstraintView::_AddElement(
 		new_elem.constraint[i].value = 0;
 	}
 
-	auto new_idx = _elementDependencies.VerticesSize();
-	_name_map.insert(std::make_pair(name, _elementDependencies.VerticesSize()));
-	_elementDependencies.PushVertex(std::move(new_elem));
-
-	auto & inserted = _elementDependencies.VertexAt(new_idx).value;
-
-	for (int i = 0; i < 4; i++)
-		if (inserted.constraint->target < _idx_nan - 4)
-			_elementDependencies.PushEdge({ inserted.constraint->target, new_idx });
-
+	if (new_idx < _elementDependencies.VerticesSize())
+		_elementDependencies.VertexAt(new_idx).value = std::move(new_elem);
+	else
+	{
+		_name_map.insert(std::make_pair(name, new_idx));
+		_elementDependencies.PushVertex(std::move(new_elem));
+	}
 	return true;
 }
 
@@ -295,6 +236,8 @@ bool ConstraintView::_InitializeD2D()
 bool ConstraintView::_InitializeElements()
 {
 	_topologicalSort.clear();
+	_drawOrder.clear();
+	_components.clear();
 	_elementDependencies.Clear();
 	_name_map = {
 		{ "ScreenLeft", _idx_nan - 1 },
@@ -302,99 +245,326 @@ bool ConstraintView::_InitializeElements()
 		{ "ScreenTop", _idx_nan - 3 },
 		{ "ScreenBottom", _idx_nan - 4 }
 	};
+	_pending.clear();
+
+	// Streamed token by token, and every element is added as soon as it is
+	// read, so only the current element and unresolved names are held aside
+	std::ifstream ifs("layout.json", std::ifstream::in | std::ifstream::binary);
+	if (!ifs)
+		return false;
+	JsonReader reader(ifs);
 
-	try
+	ViewElement elem;
+	std::vector<_AddElementArg> args;
+	std::string name;
+	if (reader.Next() != JSON_TOKEN_BEGIN_OBJECT)
+		return false;
+	for (JsonToken token = reader.Next(); token != JSON_TOKEN_END_OBJECT; token = reader.Next())
 	{
+		if (token != JSON_TOKEN_KEY)
+			return false;
+		name = reader.String();
+		if (!_ReadElement(reader, elem, args) || !_AddElement(elem, name, args))
+			return false;
+	}
+	if (reader.Next() != JSON_TOKEN_END)
+		return false;
+
+	// Constraints may name elements defined further down the file
+	for (auto & pending : _pending)
+	{
+		auto it = _name_map.find(pending.name);
+		if (it == _name_map.end())
+			return false;
+		_elementDependencies.VertexAt(pending.element).value.constraint[pending.side].target = it->second;
+	}
+	_pending.clear();
 
-		std::ifstream ifs("layout.json", std::ifstream::in);
-		json o; ifs >> o;
-		ifs.close();
+	// Edges wait until every target is known, so a replaced definition leaves none behind
+	for (ElementIndex i = 0; i < _elementDependencies.VerticesSize(); i++)
+		for (auto & constraint : _elementDependencies.VertexAt(i).value.constraint)
+			if (constraint.target < _idx_nan - 4)
+				_elementDependencies.PushEdge({ constraint.target, i });
 
-		for (auto it = o.begin(); it != o.end(); it++)
+	return _UpdateDependency();
+}
+
+bool ConstraintView::_ReadElement(JsonReader & reader, ViewElement & elem, std::vector<_AddElementArg> & args)
+{
+	if (reader.Next() != JSON_TOKEN_BEGIN_OBJECT)
+		return false;
+
+	bool content = false, constraints = false;
+	for (JsonToken token = reader.Next(); token != JSON_TOKEN_END_OBJECT; token = reader.Next())
+	{
+		if (token != JSON_TOKEN_KEY)
+			return false;
+		if (reader.String() == "content")
+		{
+			if (!_ReadContent(reader, elem))
+				return false;
+			content = true;
+		}
+		else if (reader.String() == "constraints")
 		{
-			auto & value = it.value();
-			auto & content = value.at("content");
-			auto & constraints = value.at("constraints");
+			if (!_ReadConstraints(reader, args))
+				return false;
+			constraints = true;
+		}
+		else if (!reader.Skip(reader.Next()))
+			return false;
+	}
+	return content && constraints;
+}
 
-			std::vector<_AddElementArg> args(4);
+bool ConstraintView::_ReadContent(JsonReader & reader, ViewElement & elem)
+{
+	if (reader.Next() != JSON_TOKEN_BEGIN_OBJECT)
+		return false;
 
-			for (auto jt = constraints.begin(); jt != constraints.end(); jt++)
+	elem = ViewElement(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f);
+	bool width = false, height = false, text = false;
+	for (JsonToken token = reader.Next(); token != JSON_TOKEN_END_OBJECT; token = reader.Next())
+	{
+		if (token != JSON_TOKEN_KEY)
+			return false;
+		if (reader.String() == "width" || reader.String() == "height")
+		{
+			bool isWidth = reader.String() == "width";
+			if (reader.Next() != JSON_TOKEN_NUMBER)
+				return false;
+			(isWidth ? elem.width : elem.height) = (float)reader.Number();
+			(isWidth ? width : height) = true;
+		}
+		else if (reader.String() == "text")
+		{
+			if (reader.Next() != JSON_TOKEN_STRING)
+				return false;
+			elem.content = ToWideChar(reader.String());
+			text = true;
+		}
+		else if (reader.String() == "color")
+		{
+			// Channels missing or past the first non-number keep their defaults
+			token = reader.Next();
+			if (token != JSON_TOKEN_BEGIN_ARRAY)
 			{
-				static std::map<std::string, size_t> const dir2arg {
-					{ "left", 0 },
-					{ "right", 1 },
-					{ "top", 2 },
-					{ "bottom", 3 }
-				};
-				static std::map<std::string, Direction> const dir2dir{
-					{ "left", DIRECTION_LEFT },
-					{ "right", DIRECTION_RIGHT },
-					{ "top", DIRECTION_TOP },
-					{ "bottom", DIRECTION_BOTTOM }
-				};
-
-				auto & j_value = jt.value();
-
-				size_t targ = dir2arg.at(jt.key());
-				args[targ].name = j_value.at("name").get<std::string>();
-				args[targ].direction = dir2dir.at(j_value.at("direction"));
-				args[targ].value = j_value.at("value");
+				if (!reader.Skip(token))
+					return false;
+				continue;
 			}
-
-			float width = content.at("width");
-			float height = content.at("height");
-			float r = 0.0f;
-			float g = 0.0f;
-			float b = 0.0f;
-			float a = 1.0f;
-			try
+			float * channels[] = { &elem.r, &elem.g, &elem.b, &elem.a };
+			size_t channel = 0;
+			for (token = reader.Next(); token != JSON_TOKEN_END_ARRAY; token = reader.Next())
 			{
-				auto & color = content.at("color");
-				r = color.at(0);
-				g = color.at(1);
-				b = color.at(2);
-				a = color.at(3);
+				if (token == JSON_TOKEN_NUMBER && channel < 4)
+					*channels[channel++] = (float)reader.Number();
+				else
+				{
+					channel = 4;
+					if (!reader.Skip(token))
+						return false;
+				}
 			}
-			catch (const std::exception &)
-			{}
-			std::wstring text = ToWideChar(content.at("text").get<std::string>());
-
-
-			if (!_AddElement(
-				ViewElement(
-					width, height,
-					r, g, b, a,
-					text
-				),
-				it.key(),
-				args
-			))
-				return false;
 		}
+		else if (!reader.Skip(reader.Next()))
+			return false;
 	}
-	catch (const std::exception &)
+	return width && height && text;
+}
+
+bool ConstraintView::_ReadConstraints(JsonReader & reader, std::vector<_AddElementArg> & args)
+{
+	if (reader.Next() != JSON_TOKEN_BEGIN_OBJECT)
+		return false;
+
+	args.assign(4, _AddElementArg());
+	for (JsonToken token = reader.Next(); token != JSON_TOKEN_END_OBJECT; token = reader.Next())
 	{
+		if (token != JSON_TOKEN_KEY)
+			return false;
+		// Arguments are ordered left, right, top, bottom like Direction
+		Direction side = _DirectionOf(reader.String());
+		if (side == DIRECTION_UNKNOWN || !_ReadConstraint(reader, args[side - DIRECTION_LEFT]))
+			return false;
+	}
+	return true;
+}
+
+bool ConstraintView::_ReadConstraint(JsonReader & reader, _AddElementArg & arg)
+{
+	if (reader.Next() != JSON_TOKEN_BEGIN_OBJECT)
 		return false;
+
+	bool name = false, direction = false, value = false;
+	for (JsonToken token = reader.Next(); token != JSON_TOKEN_END_OBJECT; token = reader.Next())
+	{
+		if (token != JSON_TOKEN_KEY)
+			return false;
+		if (reader.String() == "name")
+		{
+			if (reader.Next() != JSON_TOKEN_STRING)
+				return false;
+			arg.name = reader.String();
+			name = true;
+		}
+		else if (reader.String() == "direction")
+		{
+			if (reader.Next() != JSON_TOKEN_STRING)
+				return false;
+			arg.direction = _DirectionOf(reader.String());
+			if (arg.direction == DIRECTION_UNKNOWN)
+				return false;
+			direction = true;
+		}
+		else if (reader.String() == "value")
+		{
+			if (reader.Next() != JSON_TOKEN_NUMBER)
+				return false;
+			arg.value = (float)reader.Number();
+			value = true;
+		}
+		else if (!reader.Skip(reader.Next()))
+			return false;
 	}
+	return name && direction && value;
+}
 
-	return _UpdateDependency();
+Direction ConstraintView::_DirectionOf(const std::string & name)
+{
+	if (name == "left")
+		return DIRECTION_LEFT;
+	if (name == "right")
+		return DIRECTION_RIGHT;
+	if (name == "top")
+		return DIRECTION_TOP;
+	if (name == "bottom")
+		return DIRECTION_BOTTOM;
+	return DIRECTION_UNKNOWN;
 }
 
 bool ConstraintView::_UpdateDependency()
 {
 	// Check loop
-	auto scc = _elementDependencies.StronglyConnected();
-	for (auto & i : scc)
-		if (i.value.size() > 1)
-			return false;
+	auto scc = _elementDependencies.StronglyConnectedGroups();
+	if (scc.size != _elementDependencies.VerticesSize())
+		return false;
 
-	// topological sort
-	std::vector<size_t> tmp = _elementDependencies.Search();
-	_topologicalSort = std::vector<size_t>(tmp.rbegin(), tmp.rend());
+	// Constraints on both an element and its dependents add edges that ordering never needs.
+	// Components too large for dense reachability rows keep their edges.
+	_elementDependencies = _elementDependencies.TransitiveReduction(scc);
+
+	// Relabel in topological order so that solving walks the vertices sequentially
+	auto relabel = _elementDependencies.Relabel(VERTEX_ORDER_TOPOLOGICAL);
+	for (auto & elem : _elementDependencies)
+		for (auto & constraint : elem.value.constraint)
+			if (constraint.target < _idx_nan - 4)
+				constraint.target = relabel.position[constraint.target];
+	for (auto & name : _name_map)
+		if (name.second < _idx_nan - 4)
+			name.second = relabel.position[name.second];
+
+	// Vertex order no longer follows the names, so overlapping elements are
+	// still drawn in name order, as they were before relabelling
+	_drawOrder.clear();
+	for (auto & name : _name_map)
+		if (name.second < _idx_nan - 4)
+			_drawOrder.push_back(name.second);
+
+	_topologicalSort = std::vector<ElementIndex>(_elementDependencies.VerticesSize());
+	for (ElementIndex i = 0; i < _topologicalSort.size(); i++)
+		_topologicalSort[i] = i;
+
+	// split into weakly connected components, each kept in topological order
+	auto wcc = _elementDependencies.WeaklyConnected();
+	_components = std::vector<std::vector<ElementIndex>>(wcc.size);
+	for (auto i : _topologicalSort)
+		_components[wcc.group[i]].push_back(i);
 
 	return true;
 }
 
+float ConstraintView::_ValueByConstraint(const ConstraintViewElement::Constraint & constraint)
+{
+	// If the constraint targets to the edge of the screen
+	if (constraint.target == _idx_nan - 1)
+		return 0;
+	else if (constraint.target == _idx_nan - 2)
+		return (float)_width;
+	else if (constraint.target == _idx_nan - 3)
+		return 0;
+	else if (constraint.target == _idx_nan - 4)
+		return (float)_height;
+
+
+	if (constraint.target >= _elementDependencies.VerticesSize())
+		return _nan;
+
+	auto & target = _elementDependencies.VertexAt(constraint.target).value;
+	switch (constraint.targetDirection)
+	{
+	case DIRECTION_LEFT:
+		return target.x;
+	case DIRECTION_RIGHT:
+		return target.x + target.width;
+	case DIRECTION_TOP:
+		return target.y;
+	case DIRECTION_BOTTOM:
+		return target.y + target.height;
+	}
+	return _nan;
+}
+
+void ConstraintView::_SolveElement(ElementIndex idx)
+{
+	auto & elem = _elementDependencies.VertexAt(idx).value;
+	auto left	= _ValueByConstraint(elem.constraint[0]) + elem.constraint[0].value;
+	auto right	= _ValueByConstraint(elem.constraint[1]) - elem.constraint[1].value;
+	auto top	= _ValueByConstraint(elem.constraint[2]) + elem.constraint[2].value;
+	auto bottom	= _ValueByConstraint(elem.constraint[3]) - elem.constraint[3].value;
+
+	float x, y, width, height;
+
+	// horizontal
+	if (isnan(left))
+	{
+		if (isnan(right))
+			x = 0, width = 0;
+		else
+			x = right - elem.elem.width, width = elem.elem.width;
+	}
+	else
+	{
+		if (isnan(right))
+			x = left, width = elem.elem.width;
+		else if (elem.elem.width != 0)
+			x = (right + left - elem.elem.width) / 2.0f, width = elem.elem.width;
+		else
+			x = left, width = right - left;
+	}
+
+	// vertical
+	if (isnan(top))
+	{
+		if (isnan(bottom))
+			y = 0, height = 0;
+		else
+			y = bottom - elem.elem.height, height = elem.elem.height;
+	}
+	else
+	{
+		if (isnan(bottom))
+			y = top, height = elem.elem.height;
+		else if (elem.elem.height != 0)
+			y = (bottom + top - elem.elem.height) / 2.0f, height = elem.elem.height;
+		else
+			y = top, height = bottom - top;
+	}
+
+	elem.x = x, elem.y = y;
+	elem.width = width, elem.height = height;
+}
+
 void ConstraintView::_DestroyD2D()
 {
 	SafeRelease(&_pFormat);
@@ -29,6 +29,16 @@ struct ViewElement
 	{}
 };
 
+// Element ids are 32 bits wide, which halves the constraint targets, edges
+// and solver scratch arrays; define CONSTRAINT_VIEW_WIDE_INDEX for size_t ids
+#if defined(CONSTRAINT_VIEW_WIDE_INDEX)
+typedef size_t			ElementIndex;
+typedef ptrdiff_t		ElementDistance;
+#else
+typedef std::uint32_t	ElementIndex;
+typedef std::int32_t	ElementDistance;
+#endif
+
 struct ConstraintViewElement
 {
 	ViewElement elem;
@@ -37,7 +47,7 @@ struct ConstraintViewElement
 	float width, height;
 	struct Constraint
 	{
-		size_t target;
+		ElementIndex target;
 		Direction targetDirection;
 		float value;
 	} constraint[4];
@@ -79,9 +89,18 @@ private:
 	ID2D1Effect				*	_pEffect;
 	IDWriteTextFormat		*	_pFormat;
 	
-	DirectedGraph<ConstraintViewElement>	_elementDependencies;
-	std::vector<size_t>						_topologicalSort;
-	std::map<std::string, size_t>			_name_map;
+	// Elements rarely have more than a few dependents, so their edges are stored inline
+	typedef DirectedGraph<
+		ConstraintViewElement, std::vector, ElementIndex, ElementDistance,
+		SmallVectorOf<4>::Type
+	> _DependencyGraph;
+
+	_DependencyGraph						_elementDependencies;
+	std::vector<ElementIndex>				_topologicalSort;
+	std::vector<ElementIndex>				_drawOrder;
+	std::vector<std::vector<ElementIndex>>	_components;
+	std::map<std::string, ElementIndex>		_name_map;
+	ThreadPool								_pool;
 
 	struct _AddElementArg
 	{
@@ -90,20 +109,38 @@ private:
 		float value;
 	};
 
+	// Constraint naming an element further down layout.json, resolved once the file is read
+	struct _PendingTarget
+	{
+		std::string name;
+		ElementIndex element;
+		int side;
+	};
+
+	std::vector<_PendingTarget>				_pending;
+
 	bool _AddElement(
 		const ViewElement & elem,
-		std::string name,
-		std::vector<_AddElementArg> dependency
+		const std::string & name,
+		const std::vector<_AddElementArg> & dependency
 		= std::vector<_AddElementArg>()
 	);
 
 	bool _InitializeWindow();
 	bool _InitializeD2D();
 	bool _InitializeElements();
+	static bool _ReadElement(JsonReader & reader, ViewElement & elem, std::vector<_AddElementArg> & args);
+	static bool _ReadContent(JsonReader & reader, ViewElement & elem);
+	static bool _ReadConstraints(JsonReader & reader, std::vector<_AddElementArg> & args);
+	static bool _ReadConstraint(JsonReader & reader, _AddElementArg & arg);
+	static Direction _DirectionOf(const std::string & name);
 	bool _UpdateDependency();
+	float _ValueByConstraint(const ConstraintViewElement::Constraint & constraint);
+	void _SolveElement(ElementIndex idx);
 	void _DestroyD2D();
 
-	static size_t const _idx_nan;
+	// Targets from _idx_nan - 4 up are the screen edges, _idx_nan is no target
+	static ElementIndex const _idx_nan;
 	static float const _nan;
 };
 
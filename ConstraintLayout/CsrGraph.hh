@@ -0,0 +1,176 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <limits>
+#include "GraphTraits.hh"
+#include "GraphBuilder.hh"
+
+// Read-only compressed sparse row snapshot of a graph.
+// Out-edges of vertex v are Edges()[Offsets()[v] .. Offsets()[v + 1]).
+// The arrays are either owned or borrowed from external memory,
+// so the same type also serves as a zero-copy view.
+template<
+	class SizeType = std::size_t,
+	class WeightType = std::ptrdiff_t
+>
+class CsrGraph
+{
+public:
+	typedef SizeType	IndexType;
+	typedef WeightType	DistanceType;
+
+	struct Edge
+	{
+		SizeType destination;
+		WeightType weight;
+	};
+
+	class EdgeRange
+	{
+	protected:
+		const Edge * _begin;
+		const Edge * _end;
+
+	public:
+		EdgeRange(const Edge * begin, const Edge * end)
+			: _begin(begin), _end(end)
+		{ }
+		inline const Edge * begin() const { return _begin; }
+		inline const Edge * end() const { return _end; }
+		inline std::size_t size() const { return _end - _begin; }
+		inline bool empty() const { return _begin == _end; }
+		inline const Edge & operator[] (std::size_t idx) const { return _begin[idx]; }
+	};
+
+	static constexpr SizeType InvalidVertex	= std::numeric_limits<SizeType>::max();
+	static constexpr WeightType Infinity	= std::numeric_limits<WeightType>::max();
+
+protected:
+	std::vector<SizeType>	_offsetsStorage;
+	std::vector<Edge>		_edgesStorage;
+	const SizeType *		_offsets;
+	const Edge *			_edges;
+	SizeType				_verticesSize;
+
+	inline void _Own()
+	{
+		_offsets = _offsetsStorage.data();
+		_edges = _edgesStorage.data();
+		_verticesSize = _offsetsStorage.empty() ? 0 : (SizeType)_offsetsStorage.size() - 1;
+	}
+
+public:
+	CsrGraph()
+		: _offsetsStorage(1), _offsets(nullptr), _edges(nullptr), _verticesSize(0)
+	{
+		_Own();
+	}
+
+	// Takes ownership of prepared arrays; offsets holds VerticesSize() + 1 entries
+	CsrGraph(std::vector<SizeType> && offsets, std::vector<Edge> && edges)
+		: _offsetsStorage(std::move(offsets)), _edgesStorage(std::move(edges))
+	{
+		_Own();
+	}
+
+	// Bulk build from an unsorted edge list of verticesSize vertices.
+	// Edges need a source (see EdgeSource), destination and weight.
+	template<class EdgeList>
+	CsrGraph(ThreadPool & pool, SizeType verticesSize, const EdgeList & edges)
+	{
+		auto sourceOf = [&edges](std::size_t i) { return (SizeType)EdgeSource(edges[i]); };
+		auto grouped = GroupEdgesBySource(pool, verticesSize, edges.size(), sourceOf);
+		_edgesStorage.resize(edges.size());
+		ScatterGroupedEdges(pool, grouped, edges.size(), sourceOf, [&](SizeType position, std::size_t i)
+		{
+			auto & edge = edges[i];
+			_edgesStorage[position] = { (SizeType)edge.destination, (WeightType)edge.weight };
+		});
+		_offsetsStorage = std::move(grouped.offsets);
+		_Own();
+	}
+
+	// Snapshot of any graph that models the graph concept
+	template<class Graph, class = typename std::enable_if<IsGraph<Graph>::value>::type>
+	explicit CsrGraph(const Graph & graph)
+	{
+		typedef GraphTraits<Graph> Traits;
+		SizeType size = (SizeType)Traits::VerticesSize(graph);
+		_offsetsStorage.resize(size + 1);
+		for (SizeType v = 0; v < size; v++)
+		{
+			for (auto & i : Traits::EdgesFrom(graph, v))
+				_edgesStorage.push_back({ (SizeType)Traits::Destination(i), (WeightType)Traits::Weight(i) });
+			_offsetsStorage[v + 1] = (SizeType)_edgesStorage.size();
+		}
+		_Own();
+	}
+
+	CsrGraph(const CsrGraph & other)
+		: _offsetsStorage(other._offsetsStorage), _edgesStorage(other._edgesStorage),
+		_offsets(other._offsets), _edges(other._edges), _verticesSize(other._verticesSize)
+	{
+		if (other.Owning())
+			_Own();
+	}
+
+	CsrGraph(CsrGraph && other)
+		: _offsetsStorage(std::move(other._offsetsStorage)), _edgesStorage(std::move(other._edgesStorage)),
+		_offsets(other._offsets), _edges(other._edges), _verticesSize(other._verticesSize)
+	{
+		other._offsetsStorage.assign(1, 0);
+		other._Own();
+	}
+
+	CsrGraph & operator= (const CsrGraph & other)
+	{
+		if (this != &other)
+		{
+			CsrGraph copy(other);
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	CsrGraph & operator= (CsrGraph && other)
+	{
+		if (this != &other)
+		{
+			_offsetsStorage = std::move(other._offsetsStorage);
+			_edgesStorage = std::move(other._edgesStorage);
+			_offsets = other._offsets;
+			_edges = other._edges;
+			_verticesSize = other._verticesSize;
+			other._offsetsStorage.assign(1, 0);
+			other._Own();
+		}
+		return *this;
+	}
+
+	// Borrows arrays owned elsewhere; they must outlive the view
+	static CsrGraph View(const SizeType * offsets, const Edge * edges, SizeType verticesSize)
+	{
+		CsrGraph rtn;
+		rtn._offsetsStorage.clear();
+		rtn._offsets = offsets;
+		rtn._edges = edges;
+		rtn._verticesSize = verticesSize;
+		return rtn;
+	}
+
+	inline bool Owning() const { return _offsets == _offsetsStorage.data(); }
+
+	inline SizeType VerticesSize() const { return _verticesSize; }
+	inline bool VerticesEmpty() const { return _verticesSize == 0; }
+	inline SizeType EdgesSize() const { return _offsets[_verticesSize]; }
+	inline bool EdgesEmpty() const { return EdgesSize() == 0; }
+
+	inline EdgeRange EdgesFrom(SizeType idx) const
+	{
+		return EdgeRange(_edges + _offsets[idx], _edges + _offsets[idx + 1]);
+	}
+	inline SizeType OutDegree(SizeType idx) const { return _offsets[idx + 1] - _offsets[idx]; }
+
+	inline const SizeType * Offsets() const { return _offsets; }
+	inline const Edge * Edges() const { return _edges; }
+};
@@ -0,0 +1,413 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include "BitMatrix.hh"
+#include "GraphTraversal.hh"
+
+// Directed graph whose adjacency is a dense bit matrix.
+// Meant for small but dense graphs (up to a few thousand vertices), where
+// frontier expansion, closure and SCC run as word-level OR/AND-NOT over rows
+// instead of walking edges one at a time. Parallel edges collapse into one
+// and every edge has weight 1. The public interface mirrors DirectedGraph.
+template<
+	class T,
+	class SizeType = std::size_t,
+	class WeightType = std::ptrdiff_t
+>
+class DenseDirectedGraph
+{
+public:
+	typedef BitWords::WordType		WordType;
+	typedef T						ValueType;
+	typedef SizeType				IndexType;
+	typedef WeightType				DistanceType;
+
+	struct Edge {
+		friend DenseDirectedGraph;
+	protected:
+		SizeType _source;
+	public:
+		SizeType destination;
+		WeightType weight;
+		Edge()
+			: _source(), destination(), weight(1)
+		{ }
+		Edge(SizeType source, SizeType destination, WeightType weight = 1)
+			: _source(source), destination(destination), weight(weight)
+		{ }
+		inline SizeType Source() const { return _source; }
+	};
+
+	struct Vertex {
+		friend DenseDirectedGraph;
+	protected:
+		SizeType _index;
+	public:
+		ValueType value;
+		Vertex()
+			: _index(), value()
+		{ }
+		Vertex(SizeType index, const ValueType & value)
+			: _index(index), value(value)
+		{ }
+		Vertex(SizeType index, ValueType && value)
+			: _index(index), value(std::move(value))
+		{ }
+		inline SizeType Index() const { return _index; }
+	};
+
+	// Iterates the set bits of one adjacency row as edges
+	class EdgeIterator
+	{
+	public:
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef Edge						value_type;
+		typedef std::ptrdiff_t				difference_type;
+		typedef const Edge *				pointer;
+		typedef const Edge &				reference;
+
+	protected:
+		const WordType *	_row;
+		std::size_t			_words;
+		std::size_t			_word;
+		WordType			_bits;
+		Edge				_edge;
+
+		inline void _Settle()
+		{
+			while (!_bits && ++_word < _words)
+				_bits = _row[_word];
+			if (_bits)
+				_edge.destination = (SizeType)(_word * BitWords::WordBits + BitWords::CountTrailingZeros(_bits));
+		}
+
+	public:
+		EdgeIterator()
+			: _row(nullptr), _words(0), _word(0), _bits(0)
+		{ }
+		EdgeIterator(const WordType * row, std::size_t words, SizeType source, bool end)
+			: _row(row), _words(words), _word(end ? words : 0),
+			_bits(end || !words ? 0 : row[0]), _edge(source, 0)
+		{
+			if (!end)
+				_Settle();
+		}
+
+		inline reference operator* () const { return _edge; }
+		inline pointer operator-> () const { return &_edge; }
+		inline EdgeIterator & operator++ ()
+		{
+			_bits &= _bits - 1;
+			_Settle();
+			return *this;
+		}
+		inline EdgeIterator operator++ (int)
+		{
+			EdgeIterator rtn = *this;
+			++*this;
+			return rtn;
+		}
+		// Settled iterators only hold no bits once the row is exhausted
+		inline bool operator== (const EdgeIterator & other) const
+		{
+			return _bits == other._bits && (!_bits || _word == other._word);
+		}
+		inline bool operator!= (const EdgeIterator & other) const { return !(*this == other); }
+	};
+
+	class EdgeRange
+	{
+	protected:
+		const WordType *	_row;
+		std::size_t			_words;
+		SizeType			_source;
+
+	public:
+		EdgeRange(const WordType * row, std::size_t words, SizeType source)
+			: _row(row), _words(words), _source(source)
+		{ }
+		inline EdgeIterator begin() const { return EdgeIterator(_row, _words, _source, false); }
+		inline EdgeIterator end() const { return EdgeIterator(_row, _words, _source, true); }
+		inline std::size_t size() const { return BitWords::Count(_row, _words); }
+		inline bool empty() const { return !BitWords::Any(_row, _words); }
+	};
+
+	typedef std::vector<Vertex>								VertexContainerType;
+	typedef typename VertexContainerType::reference			Reference;
+	typedef typename VertexContainerType::const_reference	ConstReference;
+
+	static constexpr SizeType InvalidVertex	= std::numeric_limits<SizeType>::max();
+	static constexpr WeightType Infinity	= std::numeric_limits<WeightType>::max();
+
+	struct StronglyConnectedGroupsType
+	{
+		std::vector<SizeType> group;
+		SizeType size;
+	};
+
+protected:
+	VertexContainerType	_vertices;
+	BitMatrix			_adjacency;
+	SizeType			_edgesSize;
+
+	// Grows the matrix so that it holds at least the given number of vertices
+	void _Reserve(SizeType size)
+	{
+		if ((std::size_t)size <= _adjacency.Rows())
+			return;
+		std::size_t capacity = std::max<std::size_t>({ (std::size_t)size, _adjacency.Rows() * 2, BitWords::WordBits });
+		BitMatrix adjacency(capacity, capacity);
+		for (std::size_t i = 0; i < _adjacency.Rows(); i++)
+			std::copy(_adjacency.Row(i), _adjacency.Row(i) + _adjacency.Stride(), adjacency.Row(i));
+		_adjacency = std::move(adjacency);
+	}
+
+	inline std::size_t _Words() const { return BitWords::WordsFor(_vertices.size()); }
+
+public:
+	DenseDirectedGraph()
+		: DenseDirectedGraph(0)
+	{ }
+
+	explicit DenseDirectedGraph(SizeType num_vertices)
+		: _edgesSize(0)
+	{
+		_Reserve(num_vertices);
+		for (SizeType i = 0; i < num_vertices; i++)
+			_vertices.push_back(Vertex(i, ValueType()));
+	}
+
+	// Copies the vertices and edges of any graph with the DirectedGraph interface
+	template<class Graph, class = typename Graph::IndexType>
+	explicit DenseDirectedGraph(const Graph & graph)
+		: DenseDirectedGraph(0)
+	{
+		_Reserve((SizeType)graph.VerticesSize());
+		for (SizeType i = 0; i < (SizeType)graph.VerticesSize(); i++)
+			PushVertex(graph.VertexAt(i).value);
+		for (SizeType i = 0; i < (SizeType)graph.VerticesSize(); i++)
+			for (auto & edge : graph.EdgesFrom(i))
+				PushEdge(Edge(i, (SizeType)edge.destination));
+	}
+
+	inline ConstReference VertexAt(SizeType idx) const { return _vertices.at(idx); }
+	inline Reference VertexAt(SizeType idx) { return _vertices.at(idx); }
+	inline SizeType VerticesSize() const { return (SizeType)_vertices.size(); }
+	inline bool VerticesEmpty() const { return VerticesSize() == 0; }
+	inline SizeType EdgesSize() const { return _edgesSize; }
+	inline bool EdgesEmpty() const { return _edgesSize == 0; }
+
+	inline void PushVertex(const ValueType & new_vertex)
+	{
+		_Reserve(VerticesSize() + 1);
+		_vertices.push_back(Vertex(VerticesSize(), new_vertex));
+	}
+	inline void PushVertex(ValueType && new_vertex)
+	{
+		_Reserve(VerticesSize() + 1);
+		_vertices.push_back(Vertex(VerticesSize(), std::move(new_vertex)));
+	}
+	inline void PushEdge(const Edge & edge)
+	{
+		if (!_adjacency.Test(edge._source, edge.destination))
+		{
+			_adjacency.Set(edge._source, edge.destination);
+			_edgesSize++;
+		}
+	}
+	inline bool HasEdge(SizeType source, SizeType destination) const
+	{
+		return _adjacency.Test(source, destination);
+	}
+
+	inline EdgeRange EdgesFrom(SizeType idx) const
+	{
+		return EdgeRange(_adjacency.Row(idx), _Words(), idx);
+	}
+	// Raw adjacency row of a vertex, (VerticesSize() + 63) / 64 words long
+	inline const WordType * RowOf(SizeType idx) const { return _adjacency.Row(idx); }
+
+	inline auto begin() { return _vertices.begin(); }
+	inline auto end() { return _vertices.end(); }
+	inline auto cbegin() const { return _vertices.cbegin(); }
+	inline auto cend() const { return _vertices.cend(); }
+
+	DenseDirectedGraph Tranpose() const
+	{
+		DenseDirectedGraph rtn;
+		rtn._vertices = _vertices;
+		rtn._Reserve(VerticesSize());
+		for (SizeType i = 0; i < VerticesSize(); i++)
+			BitWords::ForEach(_adjacency.Row(i), _Words(), [&](std::size_t j)
+			{
+				rtn._adjacency.Set(j, i);
+			});
+		rtn._edgesSize = _edgesSize;
+		return rtn;
+	}
+
+	// Post-order of a depth-first search covering every vertex, like DirectedGraph::Search
+	std::vector<SizeType> Search(SizeType source = 0) const
+	{
+		std::vector<SizeType> rtn;
+		std::vector<bool> visited(VerticesSize());
+		std::vector<std::pair<SizeType, EdgeIterator>> stack;
+		auto search = [&](SizeType root)
+		{
+			if (visited[root])
+				return;
+			visited[root] = true;
+			stack.push_back({ root, EdgesFrom(root).begin() });
+			while (!stack.empty())
+			{
+				auto & top = stack.back();
+				if (top.second == EdgeIterator())
+				{
+					rtn.push_back(top.first);
+					stack.pop_back();
+					continue;
+				}
+				SizeType next = (top.second++)->destination;
+				if (!visited[next])
+				{
+					visited[next] = true;
+					stack.push_back({ next, EdgesFrom(next).begin() });
+				}
+			}
+		};
+		if (VerticesEmpty())
+			return rtn;
+		search(source);
+		for (SizeType i = 0; i < VerticesSize(); i++)
+			search(i);
+		return rtn;
+	}
+
+	inline DepthFirstRange<DenseDirectedGraph, TRAVERSAL_PRE_ORDER> PreOrder(SizeType source) const
+	{
+		return { *this, source };
+	}
+	inline DepthFirstRange<DenseDirectedGraph, TRAVERSAL_POST_ORDER> PostOrder(SizeType source) const
+	{
+		return { *this, source };
+	}
+
+	// Distance in edges from the source to every vertex, InvalidVertex if unreachable.
+	// Each level is one pass of row ORs over the frontier followed by an AND-NOT with the visited set.
+	std::vector<SizeType> BreadthFirstDepths(SizeType source) const
+	{
+		std::size_t words = _Words();
+		std::vector<SizeType> rtn(VerticesSize(), InvalidVertex);
+		std::vector<WordType> visited(words), frontier(words), next(words);
+		BitWords::Set(visited.data(), source);
+		BitWords::Set(frontier.data(), source);
+		rtn[source] = 0;
+		for (SizeType depth = 1; BitWords::Any(frontier.data(), words); depth++)
+		{
+			std::fill(next.begin(), next.end(), WordType(0));
+			BitWords::ForEach(frontier.data(), words, [&](std::size_t v)
+			{
+				BitWords::Or(next.data(), _adjacency.Row(v), words);
+			});
+			BitWords::AndNot(next.data(), visited.data(), words);
+			BitWords::Or(visited.data(), next.data(), words);
+			BitWords::ForEach(next.data(), words, [&](std::size_t v)
+			{
+				rtn[v] = depth;
+			});
+			std::swap(frontier, next);
+		}
+		return rtn;
+	}
+
+	bool Reaches(SizeType source, SizeType target) const
+	{
+		std::size_t words = _Words();
+		std::vector<WordType> visited(words), frontier(words), next(words);
+		BitWords::Set(visited.data(), source);
+		BitWords::Set(frontier.data(), source);
+		while (!BitWords::Test(visited.data(), target) && BitWords::Any(frontier.data(), words))
+		{
+			std::fill(next.begin(), next.end(), WordType(0));
+			BitWords::ForEach(frontier.data(), words, [&](std::size_t v)
+			{
+				BitWords::Or(next.data(), _adjacency.Row(v), words);
+			});
+			BitWords::AndNot(next.data(), visited.data(), words);
+			BitWords::Or(visited.data(), next.data(), words);
+			std::swap(frontier, next);
+		}
+		return BitWords::Test(visited.data(), target);
+	}
+
+	// Row i holds every vertex reachable from i, including i itself
+	BitMatrix TransitiveClosure() const
+	{
+		SizeType size = VerticesSize();
+		BitMatrix rtn(size, size);
+		for (SizeType i = 0; i < size; i++)
+		{
+			std::copy(_adjacency.Row(i), _adjacency.Row(i) + rtn.Stride(), rtn.Row(i));
+			rtn.Set(i, i);
+		}
+		// Warshall with whole rows: once k is in row i, everything k reaches is too
+		for (SizeType k = 0; k < size; k++)
+			for (SizeType i = 0; i < size; i++)
+				if (i != k && rtn.Test(i, k))
+					rtn.OrRow(i, k);
+		return rtn;
+	}
+
+	// Groups are numbered in topological order of the condensation, like DirectedGraph
+	StronglyConnectedGroupsType StronglyConnectedGroups() const
+	{
+		SizeType size = VerticesSize();
+		BitMatrix reach = TransitiveClosure();
+		BitMatrix reached(size, size);
+		for (SizeType i = 0; i < size; i++)
+			BitWords::ForEach(reach.Row(i), reach.Stride(), [&](std::size_t j)
+			{
+				reached.Set(j, i);
+			});
+
+		// A group reaches strictly more vertices than any group it has a path to
+		std::vector<SizeType> order(size), counts(size);
+		for (SizeType i = 0; i < size; i++)
+		{
+			order[i] = i;
+			counts[i] = (SizeType)reach.CountRow(i);
+		}
+		std::stable_sort(order.begin(), order.end(), [&](SizeType l, SizeType r)
+		{
+			return counts[l] > counts[r];
+		});
+
+		std::vector<SizeType> group(size, InvalidVertex);
+		std::vector<WordType> members(reach.Stride());
+		SizeType groups = 0;
+		for (auto i : order)
+		{
+			if (group[i] != InvalidVertex)
+				continue;
+			std::copy(reach.Row(i), reach.Row(i) + reach.Stride(), members.begin());
+			for (std::size_t w = 0; w < members.size(); w++)
+				members[w] &= reached.Row(i)[w];
+			BitWords::ForEach(members.data(), members.size(), [&](std::size_t j)
+			{
+				group[j] = groups;
+			});
+			groups++;
+		}
+		return { group, groups };
+	}
+
+	void Clear()
+	{
+		_vertices.clear();
+		_adjacency = BitMatrix();
+		_edgesSize = 0;
+	}
+};
@@ -2,18 +2,35 @@
 #include <vector>
 #include <utility>
 #include <limits>
+#include <algorithm>
+#include <atomic>
 #include "PriorityQueue.hh"
+#include "GraphAlgorithm.hh"
+#include "DisjointSet.hh"
+#include "ThreadPool.hh"
+#include "GraphTraversal.hh"
+#include "GraphBuilder.hh"
+#include "BitMatrix.hh"
+
+enum VertexOrder
+{
+	VERTEX_ORDER_TOPOLOGICAL,
+	VERTEX_ORDER_BREADTH_FIRST,
+	VERTEX_ORDER_REVERSE_CUTHILL_MCKEE
+};
 
 template<
 	class T,
 	template<class, class ...> class Container = std::vector,
 	class SizeType = std::size_t,
-	class WeightType = std::ptrdiff_t
+	class WeightType = std::ptrdiff_t,
+	template<class, class ...> class EdgeContainer = Container
 >
 class DirectedGraph
 {
-	template<class, template<class, class ...> class, class, class>
+	template<class, template<class, class ...> class, class, class, template<class, class ...> class>
 	friend class DirectedGraph;
+	friend struct GraphTraits<DirectedGraph>;
 
 public:
 	struct Edge {
@@ -29,11 +46,13 @@ public:
 		Edge(SizeType source, SizeType destination, WeightType weight = 0)
 			: _source(source), destination(destination), weight(weight)
 		{ }
-		inline SizeType Source() { return _source; }
+		inline SizeType Source() const { return _source; }
 	};
-	typedef Container<Edge>			EdgeContainerType;
-	typedef const Container<Edge>	ConstEdgeContainerType;
+	typedef EdgeContainer<Edge>			EdgeContainerType;
+	typedef const EdgeContainer<Edge>	ConstEdgeContainerType;
 	typedef T						ValueType;
+	typedef SizeType				IndexType;
+	typedef WeightType				DistanceType;
 	typedef Container<ValueType>	ValueContainerType;
 	struct Vertex {
 		friend DirectedGraph;
@@ -59,6 +78,14 @@ public:
 	static constexpr SizeType InvalidVertex	= std::numeric_limits<SizeType>::max();
 	static constexpr WeightType Infinity	= std::numeric_limits<WeightType>::max();
 
+	struct StronglyConnectedGroupsType
+	{
+		Container<SizeType> group;
+		SizeType size;
+	};
+
+	typedef DirectedGraph<Container<ValueType>, Container, SizeType, WeightType, EdgeContainer> StronglyConnectedType;
+
 protected:
 	VertexContainerType				_vertices;
 	Container<EdgeContainerType>	_edges;
@@ -70,11 +97,11 @@ protected:
 	}
 	inline void _AddVertex(const ValueType & value)
 	{
-		_vertices.push_back(Vertex(_vertices.size(), value));
+		_vertices.push_back(Vertex((SizeType)_vertices.size(), value));
 	}
 	inline void _AddVertex(ValueType && value)
 	{
-		_vertices.push_back(Vertex(_vertices.size(), std::move(value)));
+		_vertices.push_back(Vertex((SizeType)_vertices.size(), std::move(value)));
 	}
 	inline void _AddVertices(const ValueContainerType & vertices)
 	{
@@ -98,6 +125,91 @@ protected:
 			_AddEdge(edge);
 	}
 
+	// rank numbers the vertices in topological order
+	template<class Ranks>
+	DirectedGraph _TransitiveReduction(const Ranks & rank, SizeType limit) const
+	{
+		SizeType size = VerticesSize();
+		DirectedGraph rtn;
+		rtn._vertices = _vertices;
+		rtn._AllocateEdges();
+
+		// Members of each component, in topological order
+		auto wcc = WeaklyConnected();
+		Container<SizeType> order(size);
+		for (SizeType i = 0; i < size; i++)
+			order[rank[i]] = i;
+		Container<SizeType> start(wcc.size + 1, 0);
+		for (SizeType i = 0; i < size; i++)
+			start[wcc.group[i] + 1]++;
+		for (SizeType g = 0; g < wcc.size; g++)
+			start[g + 1] += start[g];
+		Container<SizeType> cursor(start.begin(), start.end() - 1);
+		Container<SizeType> members(size), local(size);
+		for (SizeType r = 0; r < size; r++)
+		{
+			SizeType v = order[r], g = wcc.group[v];
+			local[v] = cursor[g] - start[g];
+			members[cursor[g]++] = v;
+		}
+
+		// One matrix sized for the largest reduced component serves all of them
+		SizeType largest = 0;
+		for (SizeType g = 0; g < wcc.size; g++)
+		{
+			SizeType count = start[g + 1] - start[g];
+			if (count <= limit && count > largest)
+				largest = count;
+		}
+		BitMatrix reach(largest, largest);
+		Container<bool> direct(size);
+		std::vector<SizeType> successors;
+		for (SizeType g = 0; g < wcc.size; g++)
+		{
+			SizeType count = start[g + 1] - start[g];
+			if (count > limit || count == 1)
+			{
+				for (SizeType i = start[g]; i < start[g + 1]; i++)
+					rtn._AddEdges(_edges[members[i]]);
+				continue;
+			}
+
+			std::size_t words = BitWords::WordsFor(count);
+			for (SizeType i = count; i-- > 0;)
+			{
+				SizeType v = members[start[g] + i];
+				BitWords::WordType * row = reach.Row(i);
+				std::fill(row, row + words, BitWords::WordType(0));
+				successors.clear();
+				for (auto & edge : _edges[v])
+					successors.push_back(edge.destination);
+				std::sort(successors.begin(), successors.end(), [&local](SizeType l, SizeType r)
+				{
+					return local[l] < local[r];
+				});
+
+				for (auto w : successors)
+				{
+					if (BitWords::Test(row, local[w]))
+						continue;
+					direct[w] = true;
+					BitWords::Set(row, local[w]);
+					BitWords::Or(row, reach.Row(local[w]), words);
+				}
+
+				for (auto & edge : _edges[v])
+				{
+					if (direct[edge.destination])
+					{
+						direct[edge.destination] = false;
+						rtn._AddEdge(edge);
+					}
+				}
+			}
+		}
+		return rtn;
+	}
+
 	void _Search(SizeType idx, Container<bool> & visited, Container<SizeType> & rtn)
 	{
 		if (visited[idx])
@@ -108,6 +220,60 @@ protected:
 				_Search(i.destination, visited, rtn);
 		rtn.push_back(idx);
 	}
+	// Renumbers groups so that every edge between two groups goes from a lower to a higher group
+	void _SortGroups(Container<SizeType> & group, SizeType count)
+	{
+		Container<SizeType> offsets(count + 1), indegree(count);
+		for (auto & edges : _edges) for (auto & i : edges)
+			if (group[i._source] != group[i.destination])
+			{
+				offsets[group[i._source] + 1]++;
+				indegree[group[i.destination]]++;
+			}
+		for (SizeType g = 0; g < count; g++)
+			offsets[g + 1] += offsets[g];
+		Container<SizeType> targets(offsets[count]), cursor(offsets.begin(), offsets.end() - 1);
+		for (auto & edges : _edges) for (auto & i : edges)
+			if (group[i._source] != group[i.destination])
+				targets[cursor[group[i._source]]++] = group[i.destination];
+
+		Container<SizeType> order, position(count);
+		for (SizeType g = 0; g < count; g++)
+			if (indegree[g] == 0)
+				order.push_back(g);
+		for (SizeType head = 0; head < order.size(); head++)
+		{
+			SizeType g = order[head];
+			position[g] = head;
+			for (SizeType j = offsets[g]; j < offsets[g + 1]; j++)
+				if (--indegree[targets[j]] == 0)
+					order.push_back(targets[j]);
+		}
+		for (auto & g : group)
+			g = position[g];
+	}
+
+	StronglyConnectedType _Condensation(const StronglyConnectedGroupsType & groups)
+	{
+		StronglyConnectedType rtn;
+		auto & group = groups.group;
+		for (SizeType i = 0; i < groups.size; i++)
+			rtn.PushVertex(Container<ValueType>());
+		for (SizeType i = 0; i < VerticesSize(); i++)
+			rtn._vertices[group[i]].value.push_back(_vertices[i].value);
+		for (auto & edges : _edges)
+		{
+			for (auto & i : edges)
+			{
+				SizeType sourceGroup = group[i._source];
+				SizeType destinationGroup = group[i.destination];
+				WeightType weight = i.weight;
+				rtn.PushEdge(typename StronglyConnectedType::Edge(sourceGroup, destinationGroup, weight));
+			}
+		}
+		return rtn;
+	}
+
 public:
 	DirectedGraph()
 		: DirectedGraph(0)
@@ -144,6 +310,35 @@ public:
 		_AddEdges(edges);
 	}
 	
+	// Bulk build: edges are counting-sorted by source in parallel and every
+	// adjacency list is allocated once at its final size. The result equals
+	// pushing the edges one by one.
+	DirectedGraph(
+		ThreadPool & pool,
+		SizeType num_vertices,
+		const EdgeContainerType & edges
+	)
+		: _edges(num_vertices), _edgesSize((SizeType)edges.size())
+	{
+		_vertices.reserve(num_vertices);
+		for (SizeType i = 0; i < num_vertices; i++)
+			_AddVertex(ValueType());
+
+		auto sourceOf = [&edges](std::size_t i) { return edges[i]._source; };
+		auto grouped = GroupEdgesBySource(pool, num_vertices, edges.size(), sourceOf);
+		const std::vector<SizeType> & offsets = grouped.offsets;
+		pool.ParallelFor(0, num_vertices, [&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t v = first; v < last; v++)
+				_edges[v].resize(offsets[v + 1] - offsets[v]);
+		});
+		ScatterGroupedEdges(pool, grouped, edges.size(), sourceOf, [&](SizeType position, std::size_t i)
+		{
+			SizeType source = edges[i]._source;
+			_edges[source][position - offsets[source]] = edges[i];
+		});
+	}
+
 	DirectedGraph(
 		const DirectedGraph & other
 	)
@@ -165,6 +360,7 @@ public:
 	{
 		_vertices = other._vertices;
 		_edges = other._edges;
+		_edgesSize = other._edgesSize;
 		return *this;
 	}
 
@@ -172,12 +368,14 @@ public:
 	{
 		_vertices = std::move(other._vertices);
 		_edges = std::move(other._edges);
+		_edgesSize = other._edgesSize;
+		other._edgesSize = 0;
 		return *this;
 	}
 
 	inline ConstReference VertexAt(SizeType idx) const { return _vertices.at(idx); }
 	inline Reference VertexAt(SizeType idx) { return _vertices.at(idx); }
-	inline SizeType VerticesSize() const { return _vertices.size(); }
+	inline SizeType VerticesSize() const { return (SizeType)_vertices.size(); }
 	inline bool VerticesEmpty() const { return VerticesSize() == 0; }
 	inline SizeType EdgesSize() const { return _edgesSize; }
 	inline bool EdgesEmpty() const { return _edgesSize == 0; }
@@ -185,12 +383,12 @@ public:
 	inline void PushVertex(const ValueType & new_vertex)
 	{
 		_edges.push_back(EdgeContainerType());
-		_vertices.push_back(Vertex(_vertices.size(), new_vertex));
+		_vertices.push_back(Vertex((SizeType)_vertices.size(), new_vertex));
 	}
 	inline void PushVertex(ValueType && new_vertex)
 	{
 		_edges.push_back(EdgeContainerType());
-		_vertices.push_back(Vertex(_vertices.size(), std::move(new_vertex)));
+		_vertices.push_back(Vertex((SizeType)_vertices.size(), std::move(new_vertex)));
 	}
 	inline void PushEdge(const Edge & edge) { _AddEdge(edge); }
 
@@ -231,6 +429,31 @@ public:
 		return rtn;
 	}
 
+	// Lazy traversals from a single source; nothing beyond the frontier is materialized
+	inline DepthFirstRange<DirectedGraph, TRAVERSAL_PRE_ORDER> PreOrder(SizeType source) const
+	{
+		return { *this, source };
+	}
+	inline DepthFirstRange<DirectedGraph, TRAVERSAL_POST_ORDER> PostOrder(SizeType source) const
+	{
+		return { *this, source };
+	}
+	inline BreadthFirstRange<DirectedGraph> BreadthFirst(
+		SizeType source,
+		SizeType maxDepth = BreadthFirstRange<DirectedGraph>::Unlimited
+	) const
+	{
+		return { *this, source, maxDepth };
+	}
+
+	bool Reaches(SizeType source, SizeType target) const
+	{
+		for (auto i : PreOrder(source))
+			if (i == target)
+				return true;
+		return false;
+	}
+
 	struct DijkstraType
 	{
 		Container<SizeType> path;
@@ -240,60 +463,16 @@ public:
 	template< template<class, class ...> class QueueType = PriorityQueue>
 	DijkstraType Dijkstra(SizeType source, SizeType destination)
 	{
-		SizeType size = VerticesSize();
-		Container<SizeType> parents(size);
-		Container<WeightType> weights(size);
-		struct DijkstraInfo
-		{
-			SizeType position;
-			WeightType weight;
-		};
-		for (SizeType i = 0; i < size; i++)
-		{
-			parents[i] = InvalidVertex;
-			weights[i] = Infinity;
-		}
-		weights[source] = 0;
-
-		std::function<bool(const DijkstraInfo &, const DijkstraInfo &)> comp =
-			[](const DijkstraInfo & l, const DijkstraInfo & r)
-			{ return l.weight > r.weight; };
-
-		QueueType<DijkstraInfo, std::vector<DijkstraInfo>, decltype(comp)> queue(comp);
-		queue.Push({ source, 0 });
-
-		while (!queue.Empty())
-		{
-			DijkstraInfo info = queue.Top(); queue.Pop();
-			if (info.weight > weights[info.position])
-				continue;
-
-			for (auto & i : _edges[info.position])
-			{
-				if (weights[i.destination] > info.weight + i.weight)
-				{
-					weights[i.destination] = info.weight + i.weight;
-					parents[i.destination] = info.position;
-					queue.Push({ i.destination, weights[i.destination] });
-				}
-			}
-		}
-
-		if (weights[destination] == Infinity)
-			return { Container<SizeType>(), Infinity };
-
-		Container<SizeType> rtn_tmp;
-		SizeType current = destination;
-		while (current != source)
-		{
-			rtn_tmp.push_back(current);
-			current = parents[current];
-		}
-		Container<SizeType> rtn { source };
-		for (auto it = rtn_tmp.rbegin(); it != rtn_tmp.rend(); it++)
-			rtn.push_back(*it);
+		auto rtn = ::Dijkstra<QueueType>(*this, source, destination);
+		return { Container<SizeType>(rtn.path.begin(), rtn.path.end()), rtn.weight };
+	}
 
-		return { rtn, weights[destination] };
+	// Reuses workspace's buffers and queue across queries
+	template< template<class, class ...> class QueueType>
+	DijkstraType Dijkstra(SizeType source, SizeType destination, DijkstraWorkspace<SizeType, WeightType, QueueType> & workspace) const
+	{
+		auto rtn = ::Dijkstra(*this, source, destination, workspace);
+		return { Container<SizeType>(rtn.path.begin(), rtn.path.end()), rtn.weight };
 	}
 
 	struct BellmanFordType
@@ -305,42 +484,12 @@ public:
 	
 	BellmanFordType BellmanFord(SizeType source)
 	{
-		SizeType size = VerticesSize();
-		Container<SizeType> parents(size);
-		Container<WeightType> weights(size);
-
-		for (SizeType i = 0; i < size; i++)
-		{
-			parents[i] = InvalidVertex;
-			weights[i] = Infinity;
-		}
-		weights[source] = 0;
-
-		for (SizeType _iter = 0; _iter < size - 1; _iter++)
-		{
-			for (auto & edges : _edges) for (auto & i : edges)
-			{
-				if (weights[i._source] != Infinity
-					&& weights[i.destination] > weights[i._source] + i.weight)
-				{
-					weights[i.destination] = weights[i._source] + i.weight;
-					parents[i.destination] = i._source;
-				}
-			}
-		}
-
-		bool has_loop = false;
-		for (auto & edges : _edges) for (auto & i : edges)
-		{
-			if (weights[i._source] != Infinity
-				&& weights[i.destination] > weights[i._source] + i.weight)
-			{
-				has_loop = true;
-				break;
-			}
-		}
-
-		return { parents, weights, has_loop };
+		auto rtn = ::BellmanFord(*this, source);
+		return {
+			Container<SizeType>(rtn.parents.begin(), rtn.parents.end()),
+			Container<WeightType>(rtn.weights.begin(), rtn.weights.end()),
+			rtn.hasNegativeCycle
+		};
 	}
 
 	Container<Container<WeightType>> FloydWarshall()
@@ -368,44 +517,393 @@ public:
 		return rtn;
 	}
 
-	typedef DirectedGraph<Container<ValueType>, Container, SizeType, WeightType> StronglyConnectedType;
+	// Groups are numbered in topological order of the condensation,
+	// so every edge between two groups goes from a lower to a higher group
+	StronglyConnectedGroupsType StronglyConnectedGroups()
+	{
+		auto rtn = ::StronglyConnectedGroups(*this);
+		return { Container<SizeType>(rtn.group.begin(), rtn.group.end()), rtn.size };
+	}
 
-	StronglyConnectedType StronglyConnected()
+	struct WeaklyConnectedType
 	{
-		StronglyConnectedType rtn;
-		auto dfs = Search();
-		auto trn = Tranpose();
-		Container<SizeType> group(VerticesSize());
-		Container<bool> visited(VerticesSize());
-		for (auto it = dfs.rbegin(); it != dfs.rend(); it++)
+		Container<SizeType> group;
+		SizeType size;
+	};
+
+	// Groups are numbered in the order of their lowest vertex
+	WeaklyConnectedType WeaklyConnected() const
+	{
+		SizeType size = VerticesSize();
+		DisjointSet<SizeType, Container> sets(size);
+		for (auto & edges : _edges) for (auto & i : edges)
+			sets.Union(i._source, i.destination);
+
+		Container<SizeType> group(size);
+		Container<SizeType> rootGroup(size);
+		SizeType groups = 0;
+		for (SizeType i = 0; i < size; i++)
+			rootGroup[i] = InvalidVertex;
+		for (SizeType i = 0; i < size; i++)
 		{
-			Container<SizeType> vert;
-			trn._Search(*it, visited, vert);
-			if (!vert.empty())
+			SizeType root = sets.Find(i);
+			if (rootGroup[root] == InvalidVertex)
+				rootGroup[root] = groups++;
+			group[i] = rootGroup[root];
+		}
+		return { group, groups };
+	}
+
+	// Immediate dominator of every vertex reachable from root, see ::ImmediateDominators.
+	// Unreachable vertices get InvalidVertex.
+	Container<SizeType> Dominators(SizeType root) const
+	{
+		auto rtn = ::ImmediateDominators(*this, root);
+		return Container<SizeType>(rtn.begin(), rtn.end());
+	}
+
+	// Largest weakly connected component TransitiveReduction reduces by default;
+	// its reachability rows take the square of it in bits, 32 MiB here
+	static constexpr SizeType TransitiveReductionLimit = 16384;
+
+	// Transitive reduction of a DAG: drops duplicate edges and every edge u -> w
+	// whose w is also reachable through another successor of u. Reachability is
+	// one bit row per vertex, filled in reverse topological order, so each
+	// successor is tested against the rows of the closer ones. Every weakly
+	// connected component is reduced on its own, and components of more than
+	// limit vertices keep all their edges. Kept edges stay in their original
+	// order. A graph with cycles is returned unchanged.
+	DirectedGraph TransitiveReduction(SizeType limit = TransitiveReductionLimit) const
+	{
+		auto scc = ::StronglyConnectedGroups(*this);
+		if (scc.size != VerticesSize())
+			return *this;
+		return _TransitiveReduction(scc.group, limit);
+	}
+
+	// Same, reusing the groups of a graph the caller already found acyclic
+	DirectedGraph TransitiveReduction(const StronglyConnectedGroupsType & scc, SizeType limit = TransitiveReductionLimit) const
+	{
+		return _TransitiveReduction(scc.group, limit);
+	}
+
+	// Minimum number of vertices for a forward-backward partition to get its own task
+	static constexpr SizeType ParallelPartitionLimit = 4096;
+
+	// Parallel version of StronglyConnectedGroups().
+	// Vertices without live in- or out-edges are trimmed level by level first;
+	// what remains is split by forward-backward reachability from a pivot,
+	// and the three resulting partitions are solved as independent tasks.
+	StronglyConnectedGroupsType StronglyConnectedGroups(ThreadPool & pool)
+	{
+		typedef std::atomic<SizeType> AtomicSize;
+		SizeType size = VerticesSize();
+		if (size == 0)
+			return { Container<SizeType>(), 0 };
+
+		const SizeType Initial = 0;
+		const SizeType Done = InvalidVertex;
+		Container<SizeType> group(size);
+		AtomicSize groups(0);
+		AtomicSize colors(1);
+		std::vector<AtomicSize> inCount(size), outCount(size), color(size);
+
+		// Reverse adjacency in CSR form; self loops never matter here
+		pool.ParallelFor(0, size, [&](std::size_t first, std::size_t last)
+		{
+			for (SizeType v = (SizeType)first; v < last; v++)
+				for (auto & i : _edges[v])
+					if (i.destination != v)
+					{
+						inCount[i.destination].fetch_add(1, std::memory_order_relaxed);
+						outCount[v].fetch_add(1, std::memory_order_relaxed);
+					}
+		});
+		std::vector<SizeType> inOffsets(size + 1);
+		for (SizeType v = 0; v < size; v++)
+			inOffsets[v + 1] = inOffsets[v] + inCount[v].load(std::memory_order_relaxed);
+		std::vector<SizeType> inSources(inOffsets[size]);
+		{
+			std::vector<AtomicSize> cursor(size);
+			for (SizeType v = 0; v < size; v++)
+				cursor[v].store(inOffsets[v], std::memory_order_relaxed);
+			pool.ParallelFor(0, size, [&](std::size_t first, std::size_t last)
+			{
+				for (SizeType v = (SizeType)first; v < last; v++)
+					for (auto & i : _edges[v])
+						if (i.destination != v)
+							inSources[cursor[i.destination].fetch_add(1, std::memory_order_relaxed)] = v;
+			});
+		}
+
+		// Trimming
+		auto claim = [&](SizeType v)
+		{
+			SizeType expected = Initial;
+			return color[v].compare_exchange_strong(expected, Done);
+		};
+		std::mutex frontierMutex;
+		std::vector<SizeType> frontier;
+		pool.ParallelFor(0, size, [&](std::size_t first, std::size_t last)
+		{
+			std::vector<SizeType> local;
+			for (SizeType v = (SizeType)first; v < last; v++)
+				if ((inCount[v] == 0 || outCount[v] == 0) && claim(v))
+					local.push_back(v);
+			std::lock_guard<std::mutex> lock(frontierMutex);
+			frontier.insert(frontier.end(), local.begin(), local.end());
+		});
+		while (!frontier.empty())
+		{
+			std::vector<SizeType> next;
+			pool.ParallelFor(0, frontier.size(), [&](std::size_t first, std::size_t last)
+			{
+				std::vector<SizeType> local;
+				for (std::size_t k = first; k < last; k++)
+				{
+					SizeType v = frontier[k];
+					group[v] = groups++;
+					for (auto & i : _edges[v])
+						if (i.destination != v && --inCount[i.destination] == 0 && claim(i.destination))
+							local.push_back(i.destination);
+					for (SizeType j = inOffsets[v]; j < inOffsets[v + 1]; j++)
+						if (--outCount[inSources[j]] == 0 && claim(inSources[j]))
+							local.push_back(inSources[j]);
+				}
+				std::lock_guard<std::mutex> lock(frontierMutex);
+				next.insert(next.end(), local.begin(), local.end());
+			});
+			frontier = std::move(next);
+		}
+
+		// Forward-backward on the remaining partitions.
+		// A partition is identified by the color its vertices share;
+		// other tasks only ever recolor their own vertices to fresh colors.
+		std::vector<SizeType> remaining;
+		for (SizeType v = 0; v < size; v++)
+			if (color[v] == Initial)
+				remaining.push_back(v);
+
+		AtomicSize outstanding(0);
+		std::function<void(std::vector<SizeType> &&, SizeType)> solve;
+		solve = [&](std::vector<SizeType> && root, SizeType rootColor)
+		{
+			std::vector<std::pair<std::vector<SizeType>, SizeType>> work;
+			work.emplace_back(std::move(root), rootColor);
+			std::vector<SizeType> stack;
+			while (!work.empty())
 			{
-				SizeType vert_idx = rtn.VerticesSize();
-				Container<ValueType> vert_value;
-				for (auto & i : vert)
-					vert_value.push_back(_vertices[i].value);
-				rtn.PushVertex(std::move(vert_value));
-				for (auto & i : vert)
-					group[i] = vert_idx;
+				std::vector<SizeType> vertices = std::move(work.back().first);
+				SizeType c = work.back().second;
+				work.pop_back();
+
+				SizeType pivot = vertices.front();
+				SizeType fw = colors++, bw = colors++, scc = colors++;
+
+				color[pivot] = fw;
+				stack.push_back(pivot);
+				while (!stack.empty())
+				{
+					SizeType v = stack.back(); stack.pop_back();
+					for (auto & i : _edges[v])
+					{
+						SizeType expected = c;
+						if (color[i.destination].compare_exchange_strong(expected, fw))
+							stack.push_back(i.destination);
+					}
+				}
+
+				color[pivot] = scc;
+				stack.push_back(pivot);
+				while (!stack.empty())
+				{
+					SizeType v = stack.back(); stack.pop_back();
+					for (SizeType j = inOffsets[v]; j < inOffsets[v + 1]; j++)
+					{
+						SizeType u = inSources[j];
+						SizeType current = color[u];
+						if (current == fw)
+							color[u] = scc, stack.push_back(u);
+						else if (current == c)
+							color[u] = bw, stack.push_back(u);
+					}
+				}
+
+				std::vector<SizeType> forward, backward, rest;
+				SizeType id = groups++;
+				for (auto v : vertices)
+				{
+					SizeType current = color[v];
+					if (current == scc)
+					{
+						group[v] = id;
+						color[v] = Done;
+					}
+					else if (current == fw)
+						forward.push_back(v);
+					else if (current == bw)
+						backward.push_back(v);
+					else
+						rest.push_back(v);
+				}
+
+				for (auto * part : { &forward, &backward, &rest })
+				{
+					if (part->empty())
+						continue;
+					SizeType partColor = part == &forward ? fw : part == &backward ? bw : c;
+					if (part->size() < ParallelPartitionLimit)
+						work.emplace_back(std::move(*part), partColor);
+					else
+					{
+						outstanding++;
+						auto shared = std::make_shared<std::vector<SizeType>>(std::move(*part));
+						pool.Submit([&solve, &outstanding, shared, partColor]
+						{
+							solve(std::move(*shared), partColor);
+							outstanding--;
+						});
+					}
+				}
 			}
+		};
+		if (!remaining.empty())
+		{
+			outstanding++;
+			auto shared = std::make_shared<std::vector<SizeType>>(std::move(remaining));
+			pool.Submit([&solve, &outstanding, shared, Initial]
+			{
+				solve(std::move(*shared), Initial);
+				outstanding--;
+			});
+			pool.Wait([&outstanding] { return outstanding == 0; });
 		}
-		rtn._AllocateEdges();
-		for (auto & edges : _edges)
+
+		SizeType count = groups;
+		_SortGroups(group, count);
+		return { group, count };
+	}
+
+	StronglyConnectedType StronglyConnected()
+	{
+		return _Condensation(StronglyConnectedGroups());
+	}
+
+	inline StronglyConnectedType StronglyConnected(ThreadPool & pool)
+	{
+		return _Condensation(StronglyConnectedGroups(pool));
+	}
+	
+	// Returns the vertices in the given order; the result maps new indices to old ones
+	Container<SizeType> Order(VertexOrder order)
+	{
+		SizeType size = VerticesSize();
+		Container<SizeType> rtn;
+		if (order == VERTEX_ORDER_TOPOLOGICAL)
 		{
-			for (auto & i : edges)
+			auto dfs = Search();
+			for (auto it = dfs.rbegin(); it != dfs.rend(); it++)
+				rtn.push_back(*it);
+			return rtn;
+		}
+
+		Container<bool> visited(size);
+		if (order == VERTEX_ORDER_BREADTH_FIRST)
+		{
+			for (SizeType root = 0; root < size; root++)
 			{
-				SizeType sourceGroup = group[i._source];
-				SizeType destinationGroup = group[i.destination];
-				WeightType weight = i.weight;
-				rtn.PushEdge(typename StronglyConnectedType::Edge(sourceGroup, destinationGroup, weight));
+				if (visited[root])
+					continue;
+				visited[root] = true;
+				rtn.push_back(root);
+				for (SizeType head = (SizeType)rtn.size() - 1; head < rtn.size(); head++)
+					for (auto & i : _edges[rtn[head]])
+						if (!visited[i.destination])
+						{
+							visited[i.destination] = true;
+							rtn.push_back(i.destination);
+						}
 			}
+			return rtn;
 		}
+
+		// Cuthill-McKee runs on the undirected structure:
+		// each level is visited in increasing degree, starting from a minimum degree vertex
+		Container<Container<SizeType>> neighbors(size);
+		for (auto & edges : _edges) for (auto & i : edges)
+		{
+			if (i._source == i.destination)
+				continue;
+			neighbors[i._source].push_back(i.destination);
+			neighbors[i.destination].push_back(i._source);
+		}
+		Container<SizeType> byDegree(size);
+		for (SizeType i = 0; i < size; i++)
+			byDegree[i] = i;
+		auto lessDegree = [&neighbors](SizeType l, SizeType r)
+		{
+			return neighbors[l].size() < neighbors[r].size();
+		};
+		std::stable_sort(byDegree.begin(), byDegree.end(), lessDegree);
+		for (auto & i : neighbors)
+			std::stable_sort(i.begin(), i.end(), lessDegree);
+
+		for (auto root : byDegree)
+		{
+			if (visited[root])
+				continue;
+			visited[root] = true;
+			rtn.push_back(root);
+			for (SizeType head = (SizeType)rtn.size() - 1; head < rtn.size(); head++)
+				for (auto i : neighbors[rtn[head]])
+					if (!visited[i])
+					{
+						visited[i] = true;
+						rtn.push_back(i);
+					}
+		}
+		std::reverse(rtn.begin(), rtn.end());
 		return rtn;
 	}
-	
+
+	struct RelabelType
+	{
+		// order[new] == old, position[old] == new
+		Container<SizeType> order;
+		Container<SizeType> position;
+	};
+
+	// Permutes the vertices and their edges so that the vertex order[i] becomes i.
+	// Adjacency lists are sorted by destination afterwards.
+	RelabelType Relabel(const Container<SizeType> & order)
+	{
+		SizeType size = VerticesSize();
+		Container<SizeType> position(size);
+		for (SizeType i = 0; i < size; i++)
+			position[order[i]] = i;
+
+		VertexContainerType vertices;
+		Container<EdgeContainerType> edges(size);
+		for (SizeType i = 0; i < size; i++)
+		{
+			vertices.push_back(std::move(_vertices[order[i]]));
+			vertices.back()._index = i;
+			auto & from = _edges[order[i]];
+			auto & to = edges[i];
+			for (auto & j : from)
+				to.push_back(Edge(i, position[j.destination], j.weight));
+			std::sort(to.begin(), to.end(), [](const Edge & l, const Edge & r)
+			{
+				return l.destination < r.destination;
+			});
+		}
+		_vertices = std::move(vertices);
+		_edges = std::move(edges);
+		return { order, position };
+	}
+
+	inline RelabelType Relabel(VertexOrder order) { return Relabel(Order(order)); }
+
 	void Clear()
 	{
 		_vertices.clear();
@@ -413,4 +911,27 @@ public:
 		_edgesSize = 0;
 	}
 
+};
+
+// Lets the generic algorithms walk the adjacency lists without bounds checks
+template<
+	class T,
+	template<class, class ...> class Container,
+	class SizeType,
+	class DistanceType,
+	template<class, class ...> class EdgeContainer
+>
+struct GraphTraits<DirectedGraph<T, Container, SizeType, DistanceType, EdgeContainer>>
+{
+	typedef DirectedGraph<T, Container, SizeType, DistanceType, EdgeContainer>	Graph;
+	typedef SizeType															IndexType;
+	typedef DistanceType														WeightType;
+
+	static inline IndexType VerticesSize(const Graph & graph) { return graph.VerticesSize(); }
+	static inline typename Graph::ConstEdgeContainerType & EdgesFrom(const Graph & graph, IndexType idx)
+	{
+		return graph._edges[idx];
+	}
+	static inline IndexType Destination(const typename Graph::Edge & edge) { return edge.destination; }
+	static inline WeightType Weight(const typename Graph::Edge & edge) { return edge.weight; }
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <utility>
+
+// Union-find with union by size and path halving
+template<
+	class SizeType = std::size_t,
+	template<class, class ...> class Container = std::vector
+>
+class DisjointSet
+{
+protected:
+	Container<SizeType>	_parent;
+	Container<SizeType>	_size;
+	SizeType			_sets;
+
+public:
+	DisjointSet()
+		: DisjointSet(0)
+	{ }
+
+	explicit DisjointSet(SizeType size)
+		: _parent(size), _size(size), _sets(size)
+	{
+		for (SizeType i = 0; i < size; i++)
+		{
+			_parent[i] = i;
+			_size[i] = 1;
+		}
+	}
+
+	SizeType Find(SizeType idx)
+	{
+		while (_parent[idx] != idx)
+		{
+			_parent[idx] = _parent[_parent[idx]];
+			idx = _parent[idx];
+		}
+		return idx;
+	}
+
+	// Returns false if both were already in the same set
+	bool Union(SizeType l, SizeType r)
+	{
+		l = Find(l), r = Find(r);
+		if (l == r)
+			return false;
+		if (_size[l] < _size[r])
+			std::swap(l, r);
+		_parent[r] = l;
+		_size[l] += _size[r];
+		_sets--;
+		return true;
+	}
+
+	inline bool Same(SizeType l, SizeType r) { return Find(l) == Find(r); }
+	inline SizeType SetSize(SizeType idx) { return _size[Find(idx)]; }
+	inline SizeType SetsSize() const { return _sets; }
+	inline SizeType Size() const { return (SizeType)_parent.size(); }
+};
@@ -0,0 +1,643 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include "GraphTraits.hh"
+#include "PriorityQueue.hh"
+#include "IndexedPriorityQueue.hh"
+#include "MultiQueue.hh"
+#include "ThreadPool.hh"
+
+// Generic versions of the DirectedGraph algorithms.
+// They run on anything that models the graph concept in GraphTraits.hh,
+// so external structures are used in place without copying.
+
+template<class SizeType, class WeightType>
+struct GraphDijkstraInfo
+{
+	SizeType position;
+	WeightType weight;
+};
+
+// Puts the lightest entry on top of the max-heap PriorityQueue.
+// Stateless, so queue comparisons inline instead of going through std::function.
+// The key declaration lets d-ary heaps select children with SIMD for float
+// and int32_t weights.
+struct GraphDijkstraCompare
+{
+	template<class Info>
+	inline bool operator() (const Info & l, const Info & r) const { return l.weight > r.weight; }
+
+	template<class Info>
+	static inline auto HeapKey(const Info & info) { return info.weight; }
+	static constexpr bool HeapKeyGreater = true;
+};
+
+template<class Graph>
+struct GraphDijkstraType
+{
+	std::vector<typename GraphTraits<Graph>::IndexType> path;
+	typename GraphTraits<Graph>::WeightType weight;
+};
+
+// Scratch state for repeated Dijkstra queries. Only the vertices a query
+// touched are reset before the next one, and the queue keeps its buffer,
+// so a query costs what it visits rather than O(V) plus reallocations.
+template<
+	class SizeType,
+	class WeightType,
+	template<class, class ...> class QueueType = PriorityQueue
+>
+struct DijkstraWorkspace
+{
+	typedef GraphDijkstraInfo<SizeType, WeightType>								InfoType;
+	typedef QueueType<InfoType, std::vector<InfoType>, GraphDijkstraCompare>	Queue;
+
+	static constexpr SizeType InvalidVertex	= std::numeric_limits<SizeType>::max();
+	static constexpr WeightType Infinity	= std::numeric_limits<WeightType>::max();
+
+	std::vector<SizeType>	parents;
+	std::vector<WeightType>	weights;
+	std::vector<SizeType>	touched;
+	Queue					queue;
+
+	// Prepares for a query on a graph of size vertices
+	void Reset(SizeType size)
+	{
+		for (auto i : touched)
+		{
+			parents[i] = InvalidVertex;
+			weights[i] = Infinity;
+		}
+		touched.clear();
+		queue.Clear();
+		if (weights.size() < size)
+		{
+			parents.resize(size, InvalidVertex);
+			weights.resize(size, Infinity);
+		}
+		if constexpr (IsIndexedQueue<Queue>::value)
+			queue.Reserve(size);
+	}
+
+	// Lowers the distance of v if weight improves on it; returns whether it did
+	inline bool Relax(SizeType v, WeightType weight, SizeType parent)
+	{
+		if (weights[v] <= weight)
+			return false;
+		if (weights[v] == Infinity)
+			touched.push_back(v);
+		weights[v] = weight;
+		parents[v] = parent;
+		// An indexed queue holds one entry per vertex, so relaxing a queued vertex updates it
+		if constexpr (IsIndexedQueue<Queue>::value)
+		{
+			if (queue.Contains(v))
+			{
+				queue.DecreaseKey({ v, weight });
+				return true;
+			}
+		}
+		queue.Push({ v, weight });
+		return true;
+	}
+
+	// Settles vertices until the queue runs dry or target is settled
+	template<class Graph>
+	void Run(const Graph & graph, SizeType target)
+	{
+		typedef GraphTraits<Graph> Traits;
+		while (!queue.Empty())
+		{
+			InfoType info = queue.Top(); queue.Pop();
+			if (info.weight > weights[info.position])
+				continue;
+			if (info.position == target)
+				return;
+			for (auto & i : Traits::EdgesFrom(graph, info.position))
+				Relax((SizeType)Traits::Destination(i), info.weight + (WeightType)Traits::Weight(i), info.position);
+		}
+	}
+
+	// Distance from source to destination, or Infinity if unreachable
+	template<class Graph>
+	WeightType Search(const Graph & graph, SizeType source, SizeType destination)
+	{
+		Reset(GraphTraits<Graph>::VerticesSize(graph));
+		Relax(source, 0, InvalidVertex);
+		Run(graph, destination);
+		return weights[destination];
+	}
+
+	// Path to destination found by the last search, written into path so its storage is reused
+	void PathTo(SizeType destination, std::vector<SizeType> & path) const
+	{
+		path.clear();
+		if (weights[destination] == Infinity)
+			return;
+		for (SizeType current = destination; current != InvalidVertex; current = parents[current])
+			path.push_back(current);
+		std::reverse(path.begin(), path.end());
+	}
+};
+
+// Stops as soon as destination is settled; workspace is reused across calls
+template<
+	class Graph,
+	class SizeType,
+	class WeightType,
+	template<class, class ...> class QueueType
+>
+GraphDijkstraType<Graph> Dijkstra(
+	const Graph & graph,
+	typename GraphTraits<Graph>::IndexType source,
+	typename GraphTraits<Graph>::IndexType destination,
+	DijkstraWorkspace<SizeType, WeightType, QueueType> & workspace)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	static_assert(std::is_same<SizeType, typename GraphTraits<Graph>::IndexType>::value
+		&& std::is_same<WeightType, typename GraphTraits<Graph>::WeightType>::value,
+		"Workspace types must match the graph");
+
+	GraphDijkstraType<Graph> rtn;
+	rtn.weight = workspace.Search(graph, source, destination);
+	workspace.PathTo(destination, rtn.path);
+	return rtn;
+}
+
+template<
+	template<class, class ...> class QueueType = PriorityQueue,
+	class Graph
+>
+GraphDijkstraType<Graph> Dijkstra(
+	const Graph & graph,
+	typename GraphTraits<Graph>::IndexType source,
+	typename GraphTraits<Graph>::IndexType destination)
+{
+	typedef GraphTraits<Graph> Traits;
+	DijkstraWorkspace<typename Traits::IndexType, typename Traits::WeightType, QueueType> workspace;
+	return Dijkstra(graph, source, destination, workspace);
+}
+
+template<class Graph>
+struct GraphNearestSourceType
+{
+	std::vector<typename GraphTraits<Graph>::IndexType> parents;
+	std::vector<typename GraphTraits<Graph>::WeightType> weights;
+	std::vector<typename GraphTraits<Graph>::IndexType> nearest;
+};
+
+// One search seeded with every source, so each vertex learns its nearest
+// source (nearest) and the distance to it (weights) in a single run.
+// offsets, when given, are added to the distance of the matching source.
+// Unreachable vertices get the maximum index and weight.
+template<
+	template<class, class ...> class QueueType = PriorityQueue,
+	class Graph
+>
+GraphNearestSourceType<Graph> MultiSourceDijkstra(
+	const Graph & graph,
+	const typename GraphTraits<Graph>::IndexType * sources,
+	std::size_t sourcesSize,
+	const typename GraphTraits<Graph>::WeightType * offsets = nullptr)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	typedef GraphTraits<Graph>					Traits;
+	typedef typename Traits::IndexType			SizeType;
+	typedef typename Traits::WeightType			WeightType;
+	typedef DijkstraWorkspace<SizeType, WeightType, QueueType> Workspace;
+
+	SizeType size = Traits::VerticesSize(graph);
+	Workspace workspace;
+	workspace.Reset(size);
+	for (std::size_t i = 0; i < sourcesSize; i++)
+		workspace.Relax(sources[i], offsets ? offsets[i] : 0, Workspace::InvalidVertex);
+	workspace.Run(graph, Workspace::InvalidVertex);
+
+	GraphNearestSourceType<Graph> rtn;
+	rtn.parents = std::move(workspace.parents);
+	rtn.weights = std::move(workspace.weights);
+	rtn.nearest.assign(size, Workspace::InvalidVertex);
+
+	// A reached vertex without parent is a source; every other one inherits the source of its parent chain
+	std::vector<SizeType> chain;
+	for (SizeType v = 0; v < size; v++)
+	{
+		if (rtn.weights[v] == Workspace::Infinity || rtn.nearest[v] != Workspace::InvalidVertex)
+			continue;
+		SizeType current = v;
+		while (rtn.nearest[current] == Workspace::InvalidVertex && rtn.parents[current] != Workspace::InvalidVertex)
+		{
+			chain.push_back(current);
+			current = rtn.parents[current];
+		}
+		SizeType source = rtn.nearest[current] == Workspace::InvalidVertex ? current : rtn.nearest[current];
+		rtn.nearest[current] = source;
+		for (auto i : chain)
+			rtn.nearest[i] = source;
+		chain.clear();
+	}
+	return rtn;
+}
+
+template<class SizeType>
+struct GraphDijkstraQuery
+{
+	SizeType source;
+	SizeType destination;
+};
+
+// Workspace owned by the calling thread, shared by every batch it runs
+template<class Workspace>
+struct ThreadDijkstraWorkspace
+{
+	Workspace	workspace;
+	bool		busy = false;
+
+	static inline ThreadDijkstraWorkspace & Current()
+	{
+		static thread_local ThreadDijkstraWorkspace current;
+		return current;
+	}
+};
+
+// Answers queries[0, size) over pool, calling func(i, workspace) once the
+// search of query i finished. Every thread searches with a workspace it owns
+// and keeps across batches, so queries allocate nothing once it has grown.
+template<
+	template<class, class ...> class QueueType = PriorityQueue,
+	class Graph,
+	class Func
+>
+void ForEachDijkstra(
+	ThreadPool & pool,
+	const Graph & graph,
+	const GraphDijkstraQuery<typename GraphTraits<Graph>::IndexType> * queries,
+	std::size_t size,
+	Func && func)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	typedef GraphTraits<Graph> Traits;
+	typedef DijkstraWorkspace<typename Traits::IndexType, typename Traits::WeightType, QueueType> Workspace;
+
+	ThreadPool::SizeType grain = std::max<ThreadPool::SizeType>(size / (pool.Size() * 8), 1);
+	pool.ParallelFor(0, size, grain, [&](ThreadPool::SizeType first, ThreadPool::SizeType last)
+	{
+		// Per thread rather than per worker slot, since threads outside the
+		// pool all share one slot. A chunk run while func waits on the pool
+		// finds the workspace busy and searches with its own.
+		auto & owned = ThreadDijkstraWorkspace<Workspace>::Current();
+		Workspace nested;
+		bool outer = !owned.busy;
+		Workspace & workspace = outer ? owned.workspace : nested;
+		owned.busy = true;
+		for (auto i = first; i < last; i++)
+		{
+			workspace.Search(graph, queries[i].source, queries[i].destination);
+			func(i, (const Workspace &)workspace);
+		}
+		if (outer)
+			owned.busy = false;
+	});
+}
+
+// weights[i] receives the distance of queries[i], or the maximum weight if it is unreachable
+template<
+	template<class, class ...> class QueueType = PriorityQueue,
+	class Graph
+>
+void BatchDijkstra(
+	ThreadPool & pool,
+	const Graph & graph,
+	const GraphDijkstraQuery<typename GraphTraits<Graph>::IndexType> * queries,
+	std::size_t size,
+	typename GraphTraits<Graph>::WeightType * weights)
+{
+	ForEachDijkstra<QueueType>(pool, graph, queries, size, [&](std::size_t i, const auto & workspace)
+	{
+		weights[i] = workspace.weights[queries[i].destination];
+	});
+}
+
+// results[i] receives the path and distance of queries[i]; the path vectors
+// are overwritten in place, so reusing results across batches keeps their storage
+template<
+	template<class, class ...> class QueueType = PriorityQueue,
+	class Graph
+>
+void BatchDijkstra(
+	ThreadPool & pool,
+	const Graph & graph,
+	const GraphDijkstraQuery<typename GraphTraits<Graph>::IndexType> * queries,
+	std::size_t size,
+	GraphDijkstraType<Graph> * results)
+{
+	ForEachDijkstra<QueueType>(pool, graph, queries, size, [&](std::size_t i, const auto & workspace)
+	{
+		auto destination = queries[i].destination;
+		results[i].weight = workspace.weights[destination];
+		workspace.PathTo(destination, results[i].path);
+	});
+}
+
+// Distances from source, computed by every worker of pool popping from one
+// MultiQueue. Pops are relaxed, so a vertex may be expanded again after its
+// distance improves; entries made stale by a later improvement are dropped.
+// Weights must be non-negative. Unreachable vertices keep the maximum weight.
+template<class Graph>
+std::vector<typename GraphTraits<Graph>::WeightType> ParallelDijkstra(
+	ThreadPool & pool,
+	const Graph & graph,
+	typename GraphTraits<Graph>::IndexType source)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	typedef GraphTraits<Graph>					Traits;
+	typedef typename Traits::IndexType			SizeType;
+	typedef typename Traits::WeightType			WeightType;
+	typedef GraphDijkstraInfo<SizeType, WeightType> DijkstraInfo;
+	const WeightType Infinity = std::numeric_limits<WeightType>::max();
+
+	SizeType size = Traits::VerticesSize(graph);
+	std::unique_ptr<std::atomic<WeightType>[]> weights(new std::atomic<WeightType>[size]);
+	for (SizeType i = 0; i < size; i++)
+		weights[i].store(Infinity, std::memory_order_relaxed);
+	weights[source].store(0, std::memory_order_relaxed);
+
+	MultiQueue<DijkstraInfo, std::vector<DijkstraInfo>, GraphDijkstraCompare> queue(pool.Size() + 1);
+	queue.Push({ source, 0 });
+	// Entries pushed and not yet expanded; the search is over when it drops to zero
+	std::atomic<SizeType> active(1);
+
+	pool.ParallelFor(0, pool.Size(), 1, [&](ThreadPool::SizeType, ThreadPool::SizeType)
+	{
+		DijkstraInfo info;
+		while (active.load(std::memory_order_acquire) > 0)
+		{
+			if (!queue.TryPop(info))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			if (info.weight <= weights[info.position].load(std::memory_order_relaxed))
+			{
+				for (auto & i : Traits::EdgesFrom(graph, info.position))
+				{
+					SizeType destination = (SizeType)Traits::Destination(i);
+					WeightType weight = info.weight + (WeightType)Traits::Weight(i);
+					WeightType current = weights[destination].load(std::memory_order_relaxed);
+					while (weight < current)
+					{
+						if (weights[destination].compare_exchange_weak(current, weight, std::memory_order_relaxed))
+						{
+							active.fetch_add(1, std::memory_order_relaxed);
+							queue.Push({ destination, weight });
+							break;
+						}
+					}
+				}
+			}
+			active.fetch_sub(1, std::memory_order_release);
+		}
+	});
+
+	std::vector<WeightType> rtn(size);
+	for (SizeType i = 0; i < size; i++)
+		rtn[i] = weights[i].load(std::memory_order_relaxed);
+	return rtn;
+}
+
+template<class Graph>
+struct GraphBellmanFordType
+{
+	std::vector<typename GraphTraits<Graph>::IndexType> parents;
+	std::vector<typename GraphTraits<Graph>::WeightType> weights;
+	bool hasNegativeCycle;
+};
+
+template<class Graph>
+GraphBellmanFordType<Graph> BellmanFord(
+	const Graph & graph,
+	typename GraphTraits<Graph>::IndexType source)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	typedef GraphTraits<Graph>					Traits;
+	typedef typename Traits::IndexType			SizeType;
+	typedef typename Traits::WeightType			WeightType;
+	const SizeType InvalidVertex = std::numeric_limits<SizeType>::max();
+	const WeightType Infinity = std::numeric_limits<WeightType>::max();
+
+	SizeType size = Traits::VerticesSize(graph);
+	std::vector<SizeType> parents(size, InvalidVertex);
+	std::vector<WeightType> weights(size, Infinity);
+	weights[source] = 0;
+
+	auto relax = [&]()
+	{
+		bool changed = false;
+		for (SizeType v = 0; v < size; v++)
+		{
+			if (weights[v] == Infinity)
+				continue;
+			for (auto & i : Traits::EdgesFrom(graph, v))
+			{
+				SizeType destination = Traits::Destination(i);
+				if (weights[destination] > weights[v] + Traits::Weight(i))
+				{
+					weights[destination] = weights[v] + Traits::Weight(i);
+					parents[destination] = v;
+					changed = true;
+				}
+			}
+		}
+		return changed;
+	};
+
+	bool changed = true;
+	for (SizeType iter = 1; iter < size && changed; iter++)
+		changed = relax();
+
+	bool has_loop = changed && relax();
+	return { parents, weights, has_loop };
+}
+
+template<class Graph>
+struct GraphGroupsType
+{
+	std::vector<typename GraphTraits<Graph>::IndexType> group;
+	typename GraphTraits<Graph>::IndexType size;
+};
+
+// Iterative Tarjan. Groups are numbered in topological order of the condensation,
+// so every edge between two groups goes from a lower to a higher group.
+template<class Graph>
+GraphGroupsType<Graph> StronglyConnectedGroups(const Graph & graph)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	typedef GraphTraits<Graph>					Traits;
+	typedef typename Traits::IndexType			SizeType;
+	typedef decltype(std::begin(Traits::EdgesFrom(graph, SizeType()))) EdgeIterator;
+	const SizeType Unvisited = std::numeric_limits<SizeType>::max();
+
+	struct Frame
+	{
+		SizeType		vertex;
+		EdgeIterator	it;
+		EdgeIterator	end;
+	};
+
+	SizeType size = Traits::VerticesSize(graph);
+	std::vector<SizeType> index(size, Unvisited), low(size), group(size);
+	std::vector<bool> onStack(size);
+	std::vector<SizeType> stack;
+	std::vector<Frame> frames;
+	SizeType counter = 0, groups = 0;
+
+	auto visit = [&](SizeType v)
+	{
+		index[v] = low[v] = counter++;
+		stack.push_back(v);
+		onStack[v] = true;
+		auto && edges = Traits::EdgesFrom(graph, v);
+		frames.push_back({ v, std::begin(edges), std::end(edges) });
+	};
+
+	for (SizeType root = 0; root < size; root++)
+	{
+		if (index[root] != Unvisited)
+			continue;
+		visit(root);
+		while (!frames.empty())
+		{
+			Frame & frame = frames.back();
+			if (frame.it != frame.end)
+			{
+				SizeType next = Traits::Destination(*frame.it);
+				++frame.it;
+				if (index[next] == Unvisited)
+					visit(next);
+				else if (onStack[next] && index[next] < low[frame.vertex])
+					low[frame.vertex] = index[next];
+				continue;
+			}
+
+			SizeType v = frame.vertex;
+			frames.pop_back();
+			if (!frames.empty() && low[v] < low[frames.back().vertex])
+				low[frames.back().vertex] = low[v];
+			if (low[v] == index[v])
+			{
+				SizeType w;
+				do
+				{
+					w = stack.back(); stack.pop_back();
+					onStack[w] = false;
+					group[w] = groups;
+				} while (w != v);
+				groups++;
+			}
+		}
+	}
+
+	// Tarjan completes groups in reverse topological order
+	for (auto & g : group)
+		g = groups - 1 - g;
+	return { group, groups };
+}
+
+// Cooper-Harvey-Kennedy iterative dominators.
+// Returns the immediate dominator of every vertex reachable from root;
+// root is its own immediate dominator and unreachable vertices get
+// the maximum index. A vertex d dominates v if d is on the idom chain of v,
+// i.e. every path from root to v passes through d.
+template<class Graph>
+std::vector<typename GraphTraits<Graph>::IndexType> ImmediateDominators(
+	const Graph & graph,
+	typename GraphTraits<Graph>::IndexType root)
+{
+	static_assert(IsGraph<Graph>::value, "Graph must model the graph concept of GraphTraits");
+	typedef GraphTraits<Graph>					Traits;
+	typedef typename Traits::IndexType			SizeType;
+	typedef decltype(std::begin(Traits::EdgesFrom(graph, SizeType()))) EdgeIterator;
+	const SizeType Undefined = std::numeric_limits<SizeType>::max();
+
+	struct Frame
+	{
+		SizeType		vertex;
+		EdgeIterator	it;
+		EdgeIterator	end;
+	};
+
+	// Post-order numbers, and predecessor lists restricted to reachable vertices
+	SizeType size = Traits::VerticesSize(graph);
+	std::vector<SizeType> postOrder(size, Undefined), order;
+	std::vector<std::vector<SizeType>> predecessors(size);
+	std::vector<bool> visited(size);
+	std::vector<Frame> frames;
+	auto visit = [&](SizeType v)
+	{
+		visited[v] = true;
+		auto && edges = Traits::EdgesFrom(graph, v);
+		frames.push_back({ v, std::begin(edges), std::end(edges) });
+	};
+	visit(root);
+	while (!frames.empty())
+	{
+		Frame & frame = frames.back();
+		if (frame.it != frame.end)
+		{
+			SizeType next = Traits::Destination(*frame.it);
+			SizeType from = frame.vertex;
+			++frame.it;
+			predecessors[next].push_back(from);
+			if (!visited[next])
+				visit(next);
+			continue;
+		}
+		postOrder[frame.vertex] = (SizeType)order.size();
+		order.push_back(frame.vertex);
+		frames.pop_back();
+	}
+
+	std::vector<SizeType> idom(size, Undefined);
+	idom[root] = root;
+	auto intersect = [&](SizeType l, SizeType r)
+	{
+		while (l != r)
+		{
+			while (postOrder[l] < postOrder[r])
+				l = idom[l];
+			while (postOrder[r] < postOrder[l])
+				r = idom[r];
+		}
+		return l;
+	};
+
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		// Reverse post-order, skipping the root
+		for (SizeType i = (SizeType)order.size() - 1; i-- > 0;)
+		{
+			SizeType v = order[i];
+			SizeType dominator = Undefined;
+			for (auto p : predecessors[v])
+			{
+				if (idom[p] == Undefined)
+					continue;
+				dominator = dominator == Undefined ? p : intersect(p, dominator);
+			}
+			if (idom[v] != dominator)
+			{
+				idom[v] = dominator;
+				changed = true;
+			}
+		}
+	}
+	return idom;
+}
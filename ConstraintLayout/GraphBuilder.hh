@@ -0,0 +1,129 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "ThreadPool.hh"
+
+// Source of an input edge: either a Source() accessor, as on DirectedGraph::Edge, or a source field
+template<class Edge>
+inline auto EdgeSource(const Edge & edge) -> decltype(edge.Source()) { return edge.Source(); }
+template<class Edge>
+inline auto EdgeSource(const Edge & edge) -> decltype(edge.source) { return edge.source; }
+
+template<class SizeType>
+struct GroupedEdgesType
+{
+	std::vector<SizeType>	offsets;
+	// Edge blocks of blockSize input edges; block b writes its edges of
+	// source v from cursors[b * offsets.size() + v] on
+	std::vector<SizeType>	cursors;
+	std::size_t				blocks;
+	std::size_t				blockSize;
+};
+
+// Stable counting sort of an unsorted edge list by source, in two steps.
+// GroupEdgesBySource counts the sources of each edge block separately and
+// scans the counts in (source, block) order, so every block gets its own
+// cursors; ScatterGroupedEdges then places the blocks in parallel without
+// any shared state. sourceOf(i) gives the source of edge i. Edges of
+// vertex v land at offsets[v] .. offsets[v + 1] in their original relative
+// order, so storage built from it matches what PushEdge in a loop would produce.
+template<class SizeType, class SourceOf>
+GroupedEdgesType<SizeType> GroupEdgesBySource(
+	ThreadPool & pool,
+	SizeType verticesSize,
+	std::size_t edgesSize,
+	SourceOf && sourceOf)
+{
+	GroupedEdgesType<SizeType> grouped;
+	std::vector<SizeType> & offsets = grouped.offsets;
+	std::vector<SizeType> & cursors = grouped.cursors;
+	std::size_t stride = (std::size_t)verticesSize + 1;
+	offsets.resize(stride);
+
+	// One histogram per block, at most one block per worker
+	std::size_t blocks = std::max<std::size_t>(std::min<std::size_t>(pool.Size(), edgesSize), 1);
+	std::size_t blockSize = (edgesSize + blocks - 1) / blocks;
+	grouped.blocks = blocks;
+	grouped.blockSize = blockSize;
+	cursors.resize(blocks * stride);
+	pool.ParallelFor(0, blocks, 1, [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t b = first; b < last; b++)
+		{
+			SizeType * count = cursors.data() + b * stride;
+			std::size_t end = std::min<std::size_t>((b + 1) * blockSize, edgesSize);
+			for (std::size_t i = b * blockSize; i < end; i++)
+				count[sourceOf(i)]++;
+		}
+	});
+
+	// Exclusive scan in (source, block) order: per-range totals, a scan
+	// over the ranges, then the ranges themselves
+	std::size_t ranges = std::max<std::size_t>(pool.Size(), 1);
+	std::size_t rangeSize = (verticesSize + ranges - 1) / ranges;
+	std::vector<SizeType> rangeSums(ranges + 1);
+	if (rangeSize)
+	{
+		pool.ParallelFor(0, ranges, 1, [&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t r = first; r < last; r++)
+			{
+				SizeType sum = 0;
+				std::size_t end = std::min<std::size_t>((r + 1) * rangeSize, verticesSize);
+				for (std::size_t b = 0; b < blocks; b++)
+				{
+					const SizeType * count = cursors.data() + b * stride;
+					for (std::size_t v = r * rangeSize; v < end; v++)
+						sum += count[v];
+				}
+				rangeSums[r + 1] = sum;
+			}
+		});
+		for (std::size_t r = 0; r < ranges; r++)
+			rangeSums[r + 1] += rangeSums[r];
+		pool.ParallelFor(0, ranges, 1, [&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t r = first; r < last; r++)
+			{
+				SizeType sum = rangeSums[r];
+				std::size_t end = std::min<std::size_t>((r + 1) * rangeSize, verticesSize);
+				for (std::size_t v = r * rangeSize; v < end; v++)
+				{
+					offsets[v] = sum;
+					for (std::size_t b = 0; b < blocks; b++)
+					{
+						SizeType & cursor = cursors[b * stride + v];
+						SizeType count = cursor;
+						cursor = sum;
+						sum += count;
+					}
+				}
+			}
+		});
+	}
+	offsets[verticesSize] = (SizeType)edgesSize;
+	return grouped;
+}
+
+// Calls place(position, i) for every edge i, with position its index in the
+// grouped order. Blocks run in parallel; each position is handed out once.
+template<class SizeType, class SourceOf, class Place>
+void ScatterGroupedEdges(
+	ThreadPool & pool,
+	GroupedEdgesType<SizeType> & grouped,
+	std::size_t edgesSize,
+	SourceOf && sourceOf,
+	Place && place)
+{
+	std::size_t stride = grouped.offsets.size();
+	pool.ParallelFor(0, grouped.blocks, 1, [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t b = first; b < last; b++)
+		{
+			SizeType * cursor = grouped.cursors.data() + b * stride;
+			std::size_t end = std::min<std::size_t>((b + 1) * grouped.blockSize, edgesSize);
+			for (std::size_t i = b * grouped.blockSize; i < end; i++)
+				place(cursor[sourceOf(i)]++, i);
+		}
+	});
+}
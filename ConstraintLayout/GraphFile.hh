@@ -0,0 +1,299 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <type_traits>
+#include "CsrGraph.hh"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Versioned binary graph file, laid out so a mapped file is used in place:
+//		GraphFileHeader
+//		offsets		(verticesSize + 1) x SizeType
+//		edges		edgesSize x CsrGraph::Edge
+//		payload		verticesSize x payloadSize bytes, optional
+// Sections start on GraphFileAlignment boundaries. Index and weight widths,
+// the edge stride and the byte order are recorded and checked on open,
+// since the arrays are stored in native layout.
+static constexpr std::uint64_t GraphFileAlignment = 64;
+static constexpr std::uint32_t GraphFileVersion = 1;
+static constexpr std::uint32_t GraphFileByteOrder = 0x01020304;
+
+struct GraphFileHeader
+{
+	char			magic[8];
+	std::uint32_t	version;
+	std::uint32_t	byteOrder;
+	std::uint32_t	indexSize;
+	std::uint32_t	weightSize;
+	std::uint32_t	edgeSize;
+	std::uint32_t	payloadSize;
+	std::uint64_t	verticesSize;
+	std::uint64_t	edgesSize;
+	std::uint64_t	offsetsOffset;
+	std::uint64_t	edgesOffset;
+	std::uint64_t	payloadOffset;
+	std::uint64_t	fileSize;
+};
+
+inline const char * GraphFileMagic() { return "CLGRAPH"; }
+
+inline std::uint64_t GraphFileAlign(std::uint64_t offset)
+{
+	return (offset + GraphFileAlignment - 1) / GraphFileAlignment * GraphFileAlignment;
+}
+
+// payload, when given, holds graph.VerticesSize() records of payloadSize bytes
+template<class SizeType, class WeightType>
+bool WriteGraphFile(
+	const char * path,
+	const CsrGraph<SizeType, WeightType> & graph,
+	const void * payload = nullptr,
+	std::uint32_t payloadSize = 0)
+{
+	typedef typename CsrGraph<SizeType, WeightType>::Edge Edge;
+
+	GraphFileHeader header = {};
+	std::memcpy(header.magic, GraphFileMagic(), sizeof(header.magic));
+	header.version = GraphFileVersion;
+	header.byteOrder = GraphFileByteOrder;
+	header.indexSize = sizeof(SizeType);
+	header.weightSize = sizeof(WeightType);
+	header.edgeSize = sizeof(Edge);
+	header.payloadSize = payload ? payloadSize : 0;
+	header.verticesSize = graph.VerticesSize();
+	header.edgesSize = graph.EdgesSize();
+	header.offsetsOffset = GraphFileAlign(sizeof(GraphFileHeader));
+	header.edgesOffset = GraphFileAlign(header.offsetsOffset + (header.verticesSize + 1) * sizeof(SizeType));
+	header.payloadOffset = GraphFileAlign(header.edgesOffset + header.edgesSize * sizeof(Edge));
+	header.fileSize = header.payloadOffset + header.verticesSize * header.payloadSize;
+
+	std::ofstream ofs(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+	if (!ofs)
+		return false;
+
+	std::uint64_t written = 0;
+	auto write = [&](std::uint64_t at, const void * data, std::uint64_t size)
+	{
+		static const char zeros[GraphFileAlignment] = {};
+		ofs.write(zeros, (std::streamsize)(at - written));
+		ofs.write((const char *)data, (std::streamsize)size);
+		written = at + size;
+	};
+	write(0, &header, sizeof(header));
+	write(header.offsetsOffset, graph.Offsets(), (header.verticesSize + 1) * sizeof(SizeType));
+	// Edges are copied field by field into zeroed blocks so padding bytes do not leak into the file
+	{
+		Edge block[256];
+		std::memset(block, 0, sizeof(block));
+		std::uint64_t at = header.edgesOffset;
+		for (std::uint64_t i = 0; i < header.edgesSize; )
+		{
+			std::uint64_t count = std::min<std::uint64_t>(header.edgesSize - i, sizeof(block) / sizeof(Edge));
+			for (std::uint64_t j = 0; j < count; j++)
+			{
+				block[j].destination = graph.Edges()[i + j].destination;
+				block[j].weight = graph.Edges()[i + j].weight;
+			}
+			write(at, block, count * sizeof(Edge));
+			at += count * sizeof(Edge);
+			i += count;
+		}
+	}
+	write(header.payloadOffset, payload, header.verticesSize * header.payloadSize);
+	return (bool)ofs.flush();
+}
+
+// Any other graph is snapshotted into CSR form first
+template<class Graph, class = typename std::enable_if<IsGraph<Graph>::value>::type>
+bool WriteGraphFile(
+	const char * path,
+	const Graph & graph,
+	const void * payload = nullptr,
+	std::uint32_t payloadSize = 0)
+{
+	typedef GraphTraits<Graph> Traits;
+	CsrGraph<typename Traits::IndexType, typename Traits::WeightType> csr(graph);
+	return WriteGraphFile(path, csr, payload, payloadSize);
+}
+
+// Read-only mapping of a graph file. Graph() is a CsrGraph view straight into
+// the mapped pages, so opening only checks the header and the section bounds,
+// and the pages are shared with every other process mapping the same file.
+// Offsets and destinations are trusted unless Verify() is called, or Open is
+// asked to verify, so files from untrusted sources should be verified once.
+template<
+	class SizeType = std::size_t,
+	class WeightType = std::ptrdiff_t
+>
+class MappedGraphFile
+{
+public:
+	typedef CsrGraph<SizeType, WeightType> GraphType;
+
+protected:
+	const char *	_data;
+	std::uint64_t	_size;
+	GraphType		_graph;
+#ifdef _WIN32
+	HANDLE			_file;
+	HANDLE			_mapping;
+#endif
+
+	bool _Validate()
+	{
+		if (_size < sizeof(GraphFileHeader))
+			return false;
+		const GraphFileHeader & header = Header();
+		if (std::memcmp(header.magic, GraphFileMagic(), sizeof(header.magic)) != 0
+			|| header.version != GraphFileVersion
+			|| header.byteOrder != GraphFileByteOrder
+			|| header.indexSize != sizeof(SizeType)
+			|| header.weightSize != sizeof(WeightType)
+			|| header.edgeSize != sizeof(typename GraphType::Edge)
+			|| header.fileSize > _size
+			|| header.verticesSize > _size
+			|| header.edgesSize > _size
+			|| header.verticesSize >= (std::uint64_t)GraphType::InvalidVertex
+			|| header.offsetsOffset % GraphFileAlignment != 0
+			|| header.edgesOffset % GraphFileAlignment != 0
+			|| header.payloadOffset % GraphFileAlignment != 0
+			|| header.offsetsOffset + (header.verticesSize + 1) * sizeof(SizeType) > header.edgesOffset
+			|| header.edgesOffset + header.edgesSize * sizeof(typename GraphType::Edge) > header.payloadOffset
+			|| header.payloadOffset + header.verticesSize * header.payloadSize > header.fileSize)
+			return false;
+
+		auto offsets = (const SizeType *)(_data + header.offsetsOffset);
+		auto edges = (const typename GraphType::Edge *)(_data + header.edgesOffset);
+		if (offsets[0] != 0 || offsets[header.verticesSize] != header.edgesSize)
+			return false;
+		_graph = GraphType::View(offsets, edges, (SizeType)header.verticesSize);
+		return true;
+	}
+
+public:
+	MappedGraphFile()
+		: _data(nullptr), _size(0)
+#ifdef _WIN32
+		, _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+#endif
+	{ }
+
+	MappedGraphFile(const MappedGraphFile &) = delete;
+	MappedGraphFile & operator= (const MappedGraphFile &) = delete;
+
+	~MappedGraphFile() { Close(); }
+
+	bool Open(const char * path, bool verify = false)
+	{
+		Close();
+#ifdef _WIN32
+		_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return false;
+		}
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (_mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+		_data = (const char *)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+		_size = (std::uint64_t)size.QuadPart;
+#else
+		int fd = ::open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			::close(fd);
+			return false;
+		}
+		void * data = mmap(nullptr, (std::size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (data != MAP_FAILED)
+		{
+			_data = (const char *)data;
+			_size = (std::uint64_t)st.st_size;
+		}
+#endif
+		if (_data == nullptr || !_Validate() || (verify && !Verify()))
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (_data)
+			UnmapViewOfFile(_data);
+		if (_mapping)
+			CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE)
+			CloseHandle(_file);
+		_mapping = nullptr;
+		_file = INVALID_HANDLE_VALUE;
+#else
+		if (_data)
+			munmap((void *)_data, (std::size_t)_size);
+#endif
+		_data = nullptr;
+		_size = 0;
+		_graph = GraphType();
+	}
+
+	// Checks every edge range and destination, one pass over the offsets and
+	// edges; once it holds, EdgesFrom never reads out of bounds
+	bool Verify() const
+	{
+		if (_data == nullptr)
+			return false;
+		const GraphFileHeader & header = Header();
+		auto offsets = _graph.Offsets();
+		auto edges = _graph.Edges();
+		for (std::uint64_t v = 0; v < header.verticesSize; v++)
+			if (offsets[v] > offsets[v + 1])
+				return false;
+		for (std::uint64_t i = 0; i < header.edgesSize; i++)
+			if ((std::uint64_t)edges[i].destination >= header.verticesSize)
+				return false;
+		return true;
+	}
+
+	inline bool IsOpen() const { return _data != nullptr; }
+	inline const GraphFileHeader & Header() const { return *(const GraphFileHeader *)_data; }
+	inline const GraphType & Graph() const { return _graph; }
+
+	// Payload record of vertex idx, or nullptr if the file has none
+	inline const void * Payload(SizeType idx) const
+	{
+		const GraphFileHeader & header = Header();
+		if (header.payloadSize == 0)
+			return nullptr;
+		return _data + header.payloadOffset + (std::uint64_t)idx * header.payloadSize;
+	}
+
+	template<class PayloadType>
+	inline const PayloadType * PayloadAs() const
+	{
+		static_assert(std::is_trivially_copyable<PayloadType>::value, "Payload must be trivially copyable");
+		return Header().payloadSize == sizeof(PayloadType) ? (const PayloadType *)Payload(0) : nullptr;
+	}
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <utility>
+#include <type_traits>
+#include <iterator>
+
+// Minimal graph concept used by the generic algorithms in GraphAlgorithm.hh.
+// GraphTraits<Graph> must provide
+//		IndexType, WeightType
+//		static IndexType VerticesSize(const Graph &)
+//		static auto EdgesFrom(const Graph &, IndexType)		iterable over the out-edges
+//		static IndexType Destination(const Edge &)
+//		static WeightType Weight(const Edge &)
+// The primary template forwards to the members used by DirectedGraph:
+// IndexType, DistanceType, VerticesSize(), EdgesFrom() and edges with
+// destination and weight fields. Foreign graph structures specialize it
+// instead of being copied into a DirectedGraph.
+template<class ...>
+using GraphVoidType = void;
+
+template<class Graph, class = void>
+struct GraphMemberTraits
+{ };
+
+template<class Graph>
+struct GraphMemberTraits<Graph, GraphVoidType<typename Graph::IndexType, typename Graph::DistanceType>>
+{
+	typedef typename Graph::IndexType		IndexType;
+	typedef typename Graph::DistanceType	WeightType;
+
+	static inline IndexType VerticesSize(const Graph & graph) { return (IndexType)graph.VerticesSize(); }
+	static inline decltype(auto) EdgesFrom(const Graph & graph, IndexType idx) { return graph.EdgesFrom(idx); }
+
+	template<class Edge>
+	static inline IndexType Destination(const Edge & edge) { return (IndexType)edge.destination; }
+	template<class Edge>
+	static inline WeightType Weight(const Edge & edge) { return (WeightType)edge.weight; }
+};
+
+template<class Graph>
+struct GraphTraits : GraphMemberTraits<Graph>
+{ };
+
+// Whether GraphTraits<Graph> satisfies the concept above
+template<class Graph, class = void>
+struct IsGraph : std::false_type
+{ };
+
+template<class Graph>
+struct IsGraph<Graph, GraphVoidType<
+	typename GraphTraits<Graph>::IndexType,
+	typename GraphTraits<Graph>::WeightType,
+	decltype(GraphTraits<Graph>::VerticesSize(std::declval<const Graph &>())),
+	decltype(GraphTraits<Graph>::Destination(
+		*std::begin(GraphTraits<Graph>::EdgesFrom(std::declval<const Graph &>(), typename GraphTraits<Graph>::IndexType())))),
+	decltype(GraphTraits<Graph>::Weight(
+		*std::begin(GraphTraits<Graph>::EdgesFrom(std::declval<const Graph &>(), typename GraphTraits<Graph>::IndexType()))))
+>> : std::true_type
+{ };
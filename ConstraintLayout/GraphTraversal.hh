@@ -0,0 +1,239 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <limits>
+#include <iterator>
+#include "GraphTraits.hh"
+#include "BitMatrix.hh"
+
+enum TraversalOrder
+{
+	TRAVERSAL_PRE_ORDER,
+	TRAVERSAL_POST_ORDER
+};
+
+// Visited set of the traversal ranges: one bit per vertex. A range allocates
+// its own unless one is passed in, so repeated walks can share the storage.
+class TraversalVisited
+{
+protected:
+	std::vector<BitWords::WordType> _words;
+
+public:
+	// Unmarks every vertex below size
+	inline void Reset(std::size_t size)
+	{
+		_words.assign(BitWords::WordsFor(size), BitWords::WordType(0));
+	}
+
+	// Marks idx; returns whether it was unmarked
+	inline bool Insert(std::size_t idx)
+	{
+		if (BitWords::Test(_words.data(), idx))
+			return false;
+		BitWords::Set(_words.data(), idx);
+		return true;
+	}
+
+	inline bool Contains(std::size_t idx) const { return BitWords::Test(_words.data(), idx); }
+};
+
+// Single-pass input iterator shared by the traversal ranges below.
+// All state lives in the range, so copies of an iterator advance together.
+template<class Range>
+class TraversalIterator
+{
+public:
+	typedef std::input_iterator_tag				iterator_category;
+	typedef typename Range::IndexType			value_type;
+	typedef std::ptrdiff_t						difference_type;
+	typedef const value_type *					pointer;
+	typedef const value_type &					reference;
+
+protected:
+	Range * _range;
+
+public:
+	TraversalIterator(Range * range = nullptr)
+		: _range(range && range->_Done() ? nullptr : range)
+	{ }
+
+	inline reference operator* () const { return _range->_current; }
+	inline pointer operator-> () const { return &_range->_current; }
+
+	inline TraversalIterator & operator++ ()
+	{
+		if (!_range->_Advance())
+			_range = nullptr;
+		return *this;
+	}
+	inline void operator++ (int) { ++*this; }
+
+	inline bool operator== (const TraversalIterator & other) const { return _range == other._range; }
+	inline bool operator!= (const TraversalIterator & other) const { return _range != other._range; }
+};
+
+// Lazy depth-first traversal from one source.
+// Only the current path and a visited bit per vertex are allocated,
+// so breaking out of a range-for stops the search immediately.
+template<class Graph, TraversalOrder Order = TRAVERSAL_PRE_ORDER>
+class DepthFirstRange
+{
+	friend class TraversalIterator<DepthFirstRange>;
+
+public:
+	typedef GraphTraits<Graph>						Traits;
+	typedef typename Traits::IndexType				IndexType;
+	typedef TraversalIterator<DepthFirstRange>		Iterator;
+
+protected:
+	typedef decltype(std::begin(Traits::EdgesFrom(std::declval<const Graph &>(), IndexType()))) _EdgeIterator;
+
+	struct _Frame
+	{
+		IndexType		vertex;
+		_EdgeIterator	it;
+		_EdgeIterator	end;
+	};
+
+	const Graph *						_graph;
+	std::vector<_Frame>					_stack;
+	std::unique_ptr<TraversalVisited>	_ownVisited;
+	TraversalVisited *					_visited;
+	IndexType							_current;
+	bool								_done;
+
+	inline void _Push(IndexType vertex)
+	{
+		auto && edges = Traits::EdgesFrom(*_graph, vertex);
+		_stack.push_back({ vertex, std::begin(edges), std::end(edges) });
+	}
+
+	bool _Advance()
+	{
+		while (!_stack.empty())
+		{
+			_Frame & frame = _stack.back();
+			if (frame.it == frame.end)
+			{
+				IndexType vertex = frame.vertex;
+				_stack.pop_back();
+				if (Order == TRAVERSAL_POST_ORDER)
+				{
+					_current = vertex;
+					return true;
+				}
+				continue;
+			}
+			IndexType next = Traits::Destination(*frame.it);
+			++frame.it;
+			if (_visited->Insert(next))
+			{
+				_Push(next);
+				if (Order == TRAVERSAL_PRE_ORDER)
+				{
+					_current = next;
+					return true;
+				}
+			}
+		}
+		_done = true;
+		return false;
+	}
+
+	inline bool _Done() const { return _done; }
+
+public:
+	// visited, when given, is reset and used instead of a set of the range's own
+	DepthFirstRange(const Graph & graph, IndexType source, TraversalVisited * visited = nullptr)
+		: _graph(&graph), _ownVisited(visited ? nullptr : new TraversalVisited),
+		_visited(visited ? visited : _ownVisited.get()), _current(source), _done(false)
+	{
+		_visited->Reset(Traits::VerticesSize(graph));
+		_visited->Insert(source);
+		_Push(source);
+		if (Order == TRAVERSAL_POST_ORDER)
+			_Advance();
+	}
+
+	DepthFirstRange(const DepthFirstRange &) = delete;
+	DepthFirstRange(DepthFirstRange &&) = default;
+
+	inline Iterator begin() { return Iterator(this); }
+	inline Iterator end() { return Iterator(); }
+};
+
+// Lazy breadth-first traversal from one source, optionally limited in depth.
+// Only the frontier and a visited bit per vertex are allocated.
+template<class Graph>
+class BreadthFirstRange
+{
+	friend class TraversalIterator<BreadthFirstRange>;
+
+public:
+	typedef GraphTraits<Graph>						Traits;
+	typedef typename Traits::IndexType				IndexType;
+	typedef TraversalIterator<BreadthFirstRange>	Iterator;
+
+	static constexpr IndexType Unlimited = std::numeric_limits<IndexType>::max();
+
+protected:
+	struct _Entry
+	{
+		IndexType	vertex;
+		IndexType	depth;
+	};
+
+	const Graph *						_graph;
+	std::deque<_Entry>					_queue;
+	std::unique_ptr<TraversalVisited>	_ownVisited;
+	TraversalVisited *					_visited;
+	IndexType							_maxDepth;
+	IndexType							_current;
+	IndexType							_depth;
+	bool								_done;
+
+	bool _Advance()
+	{
+		if (_queue.empty())
+		{
+			_done = true;
+			return false;
+		}
+		_Entry entry = _queue.front(); _queue.pop_front();
+		_current = entry.vertex;
+		_depth = entry.depth;
+		if (_depth < _maxDepth)
+			for (auto && i : Traits::EdgesFrom(*_graph, _current))
+			{
+				IndexType next = Traits::Destination(i);
+				if (_visited->Insert(next))
+					_queue.push_back({ next, IndexType(_depth + 1) });
+			}
+		return true;
+	}
+
+	inline bool _Done() const { return _done; }
+
+public:
+	// visited, when given, is reset and used instead of a set of the range's own
+	BreadthFirstRange(const Graph & graph, IndexType source, IndexType maxDepth = Unlimited, TraversalVisited * visited = nullptr)
+		: _graph(&graph), _ownVisited(visited ? nullptr : new TraversalVisited),
+		_visited(visited ? visited : _ownVisited.get()), _maxDepth(maxDepth), _current(source), _depth(0), _done(false)
+	{
+		_visited->Reset(Traits::VerticesSize(graph));
+		_visited->Insert(source);
+		_queue.push_back({ source, 0 });
+		_Advance();
+	}
+
+	BreadthFirstRange(const BreadthFirstRange &) = delete;
+	BreadthFirstRange(BreadthFirstRange &&) = default;
+
+	// Number of edges between the source and the current vertex
+	inline IndexType Depth() const { return _depth; }
+
+	inline Iterator begin() { return Iterator(this); }
+	inline Iterator end() { return Iterator(); }
+};
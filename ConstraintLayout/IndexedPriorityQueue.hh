@@ -0,0 +1,190 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <utility>
+#include <functional>
+#include <type_traits>
+#include "GraphTraits.hh"
+
+// Default key extractor: entries carry their vertex in a position field, as GraphDijkstraInfo does
+struct HeapPositionIndex
+{
+	template<class Value>
+	inline std::size_t operator() (const Value & value) const { return (std::size_t)value.position; }
+};
+
+// Binary max-heap, ordered like PriorityQueue, that holds at most one entry
+// per index and tracks where each one sits. Entries are updated in place
+// with DecreaseKey or Update instead of being pushed again, so the heap
+// never grows beyond the number of distinct indices.
+template<
+	class T,
+	class Container = std::vector<T>,
+	class Compare = std::less<typename Container::value_type>,
+	class IndexOf = HeapPositionIndex
+>
+class IndexedPriorityQueue
+{
+public:
+	typedef Container							ContainerType;
+	typedef Compare								ValueCompare;
+	typedef typename Container::value_type		ValueType;
+	typedef typename Container::size_type		SizeType;
+	typedef typename Container::reference		Reference;
+	typedef typename Container::const_reference	ConstReference;
+
+	static constexpr SizeType NotInQueue = std::numeric_limits<SizeType>::max();
+
+protected:
+	Container				_c;
+	Compare					_comp;
+	IndexOf					_index;
+	std::vector<SizeType>	_positions;
+
+#if defined(_DEBUG)
+	inline Reference _At(SizeType idx) { return _c.at(idx); }
+#else
+	inline Reference _At(SizeType idx) { return _c[idx]; }
+#endif
+
+	inline SizeType _Parent(SizeType idx) { return (idx - 1) / 2; }
+	inline SizeType _Left(SizeType idx) { return idx * 2 + 1; }
+
+	inline SizeType & _PositionOf(const ValueType & value)
+	{
+		SizeType key = (SizeType)_index(value);
+		if (key >= _positions.size())
+			_positions.resize(key + 1, NotInQueue);
+		return _positions[key];
+	}
+
+	inline void _Place(SizeType idx, ValueType && value)
+	{
+		_At(idx) = std::move(value);
+		_PositionOf(_At(idx)) = idx;
+	}
+
+	// Both sifts carry the entry in a hole rather than swapping at every level
+	void _SiftUp(SizeType idx)
+	{
+		ValueType value = std::move(_At(idx));
+		while (idx)
+		{
+			SizeType p = _Parent(idx);
+			if (!_comp(_At(p), value))
+				break;
+			_Place(idx, std::move(_At(p)));
+			idx = p;
+		}
+		_Place(idx, std::move(value));
+	}
+
+	void _SiftDown(SizeType idx)
+	{
+		SizeType size = _c.size();
+		ValueType value = std::move(_At(idx));
+		for (;;)
+		{
+			SizeType t = _Left(idx);
+			if (t >= size)
+				break;
+			if (t + 1 < size && _comp(_At(t), _At(t + 1)))
+				t++;
+			if (!_comp(value, _At(t)))
+				break;
+			_Place(idx, std::move(_At(t)));
+			idx = t;
+		}
+		_Place(idx, std::move(value));
+	}
+
+public:
+	IndexedPriorityQueue()
+		: IndexedPriorityQueue(Compare()) { }
+
+	explicit IndexedPriorityQueue(const Compare & compare, const IndexOf & index = IndexOf())
+		: _c(), _comp(compare), _index(index)
+	{ }
+
+	inline ConstReference Top() const { return _c.front(); }
+	bool Empty() const { return Size() == 0; }
+	SizeType Size() const { return _c.size(); }
+
+	inline bool Contains(std::size_t index) const
+	{
+		return index < _positions.size() && _positions[index] != NotInQueue;
+	}
+
+	// Sizes the position map for indices below size up front
+	inline void Reserve(SizeType size)
+	{
+		if (size > _positions.size())
+			_positions.resize(size, NotInQueue);
+		_c.reserve(size);
+	}
+
+	// Inserts the entry, or updates the one with the same index
+	void Push(ValueType value)
+	{
+		SizeType position = _PositionOf(value);
+		if (position != NotInQueue)
+		{
+			Update(std::move(value));
+			return;
+		}
+		_c.push_back(std::move(value));
+		_SiftUp(_c.size() - 1);
+	}
+
+	// Replaces the queued entry with the same index by one of higher priority
+	void DecreaseKey(ValueType value)
+	{
+		SizeType position = _PositionOf(value);
+		_At(position) = std::move(value);
+		_SiftUp(position);
+	}
+
+	// Replaces the queued entry with the same index, in either direction
+	void Update(ValueType value)
+	{
+		SizeType position = _PositionOf(value);
+		bool up = _comp(_At(position), value);
+		_At(position) = std::move(value);
+		if (up)
+			_SiftUp(position);
+		else
+			_SiftDown(position);
+	}
+
+	void Pop()
+	{
+		_PositionOf(_c.front()) = NotInQueue;
+		if (_c.size() > 1)
+		{
+			_c.front() = std::move(_c.back());
+			_c.pop_back();
+			_SiftDown(0);
+		}
+		else
+			_c.pop_back();
+	}
+
+	void Clear()
+	{
+		for (auto & i : _c)
+			_PositionOf(i) = NotInQueue;
+		_c.clear();
+	}
+};
+
+// Whether QueueType keeps one entry per index and supports DecreaseKey
+template<class Queue, class = void>
+struct IsIndexedQueue : std::false_type
+{ };
+
+template<class Queue>
+struct IsIndexedQueue<Queue, GraphVoidType<
+	decltype(std::declval<const Queue &>().Contains(std::size_t())),
+	decltype(std::declval<Queue &>().DecreaseKey(std::declval<typename Queue::ValueType>()))
+>> : std::true_type
+{ };
@@ -0,0 +1,361 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <istream>
+#include <cstdlib>
+#include <cstdint>
+#include <clocale>
+#include <algorithm>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+enum JsonToken
+{
+	JSON_TOKEN_ERROR,
+	JSON_TOKEN_END,
+	JSON_TOKEN_BEGIN_OBJECT,
+	JSON_TOKEN_END_OBJECT,
+	JSON_TOKEN_BEGIN_ARRAY,
+	JSON_TOKEN_END_ARRAY,
+	JSON_TOKEN_KEY,
+	JSON_TOKEN_STRING,
+	JSON_TOKEN_NUMBER,
+	JSON_TOKEN_TRUE,
+	JSON_TOKEN_FALSE,
+	JSON_TOKEN_NULL
+};
+
+// Pull tokenizer for JSON read from a stream in fixed-size blocks.
+// Nothing is kept beyond the current token and the nesting stack, so memory
+// does not grow with the document, and errors are reported as
+// JSON_TOKEN_ERROR rather than thrown. Keys and strings are UTF-8 in String(),
+// whose storage is reused from token to token.
+class JsonReader
+{
+public:
+	typedef std::size_t SizeType;
+
+protected:
+	enum _State
+	{
+		_STATE_VALUE,
+		_STATE_KEY,
+		_STATE_NEXT,
+		_STATE_ERROR
+	};
+
+	std::istream &		_in;
+	std::vector<char>	_buffer;
+	SizeType			_pos;
+	SizeType			_end;
+	std::vector<char>	_stack;
+	_State				_state;
+	// Just after a bracket, where the closing bracket may follow at once
+	bool				_first;
+	std::string			_string;
+	double				_number;
+
+	inline int _Peek()
+	{
+		if (_pos == _end)
+		{
+			_in.read(_buffer.data(), (std::streamsize)_buffer.size());
+			_pos = 0;
+			_end = (SizeType)_in.gcount();
+			if (_end == 0)
+				return -1;
+		}
+		return (unsigned char)_buffer[_pos];
+	}
+
+	inline int _Get()
+	{
+		int c = _Peek();
+		if (c >= 0)
+			_pos++;
+		return c;
+	}
+
+	inline void _SkipSpace()
+	{
+		for (int c = _Peek(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = _Peek())
+			_pos++;
+	}
+
+	inline JsonToken _Fail()
+	{
+		_state = _STATE_ERROR;
+		return JSON_TOKEN_ERROR;
+	}
+
+	bool _Expect(const char * literal)
+	{
+		for (; *literal; literal++)
+			if (_Get() != (unsigned char)*literal)
+				return false;
+		return true;
+	}
+
+	int _Hex4()
+	{
+		int rtn = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			int c = _Get();
+			rtn <<= 4;
+			if (c >= '0' && c <= '9')
+				rtn |= c - '0';
+			else if (c >= 'a' && c <= 'f')
+				rtn |= c - 'a' + 10;
+			else if (c >= 'A' && c <= 'F')
+				rtn |= c - 'A' + 10;
+			else
+				return -1;
+		}
+		return rtn;
+	}
+
+	void _PutUtf8(std::uint32_t code)
+	{
+		if (code < 0x80)
+			_string.push_back((char)code);
+		else if (code < 0x800)
+		{
+			_string.push_back((char)(0xC0 | (code >> 6)));
+			_string.push_back((char)(0x80 | (code & 0x3F)));
+		}
+		else if (code < 0x10000)
+		{
+			_string.push_back((char)(0xE0 | (code >> 12)));
+			_string.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+			_string.push_back((char)(0x80 | (code & 0x3F)));
+		}
+		else
+		{
+			_string.push_back((char)(0xF0 | (code >> 18)));
+			_string.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+			_string.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+			_string.push_back((char)(0x80 | (code & 0x3F)));
+		}
+	}
+
+	// Reads the string after its opening quote into _string
+	bool _ReadString()
+	{
+		_string.clear();
+		for (;;)
+		{
+			// Copy unescaped runs straight out of the buffer
+			SizeType start = _pos;
+			while (_pos < _end && _buffer[_pos] != '"' && _buffer[_pos] != '\\' && (unsigned char)_buffer[_pos] >= 0x20)
+				_pos++;
+			_string.append(_buffer.data() + start, _pos - start);
+
+			int c = _Get();
+			if (c == '"')
+				return true;
+			// Control characters and EOF end the run as well
+			if (c < 0x20)
+				return false;
+			// The run stopped at the end of the buffer
+			if (c != '\\')
+			{
+				_string.push_back((char)c);
+				continue;
+			}
+			switch (_Get())
+			{
+			case '"':	_string.push_back('"'); break;
+			case '\\':	_string.push_back('\\'); break;
+			case '/':	_string.push_back('/'); break;
+			case 'b':	_string.push_back('\b'); break;
+			case 'f':	_string.push_back('\f'); break;
+			case 'n':	_string.push_back('\n'); break;
+			case 'r':	_string.push_back('\r'); break;
+			case 't':	_string.push_back('\t'); break;
+			case 'u':
+			{
+				int code = _Hex4();
+				if (code < 0)
+					return false;
+				if (code >= 0xD800 && code <= 0xDBFF)
+				{
+					if (!_Expect("\\u"))
+						return false;
+					int low = _Hex4();
+					if (low < 0xDC00 || low > 0xDFFF)
+						return false;
+					_PutUtf8(0x10000 + (((std::uint32_t)code - 0xD800) << 10) + ((std::uint32_t)low - 0xDC00));
+				}
+				else if (code >= 0xDC00 && code <= 0xDFFF)
+					return false;
+				else
+					_PutUtf8((std::uint32_t)code);
+				break;
+			}
+			default:
+				return false;
+			}
+		}
+	}
+
+	bool _ReadNumber()
+	{
+		char text[64];
+		SizeType size = 0;
+		for (int c = _Peek(); (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'; c = _Peek())
+		{
+			if (size + 1 == sizeof(text))
+				return false;
+			text[size++] = (char)_Get();
+		}
+		text[size] = '\0';
+		// Both paths are laxer than JSON about leading zeros; the layout does not depend on it.
+		// Neither depends on the C locale, which may expect a decimal comma.
+#if defined(__cpp_lib_to_chars)
+		auto result = std::from_chars(text, text + size, _number);
+		return size > 0 && result.ec == std::errc() && result.ptr == text + size;
+#else
+		// Toolsets without floating-point from_chars: hand strtod the decimal point it expects
+		char point = *std::localeconv()->decimal_point;
+		if (point != '.')
+			std::replace(text, text + size, '.', point);
+		char * end;
+		_number = std::strtod(text, &end);
+		return size > 0 && end == text + size;
+#endif
+	}
+
+	inline JsonToken _Open(char bracket, JsonToken token)
+	{
+		_stack.push_back(bracket);
+		_state = bracket == '{' ? _STATE_KEY : _STATE_VALUE;
+		_first = true;
+		return token;
+	}
+
+	inline JsonToken _Close()
+	{
+		char bracket = _stack.back();
+		_stack.pop_back();
+		_state = _STATE_NEXT;
+		return bracket == '{' ? JSON_TOKEN_END_OBJECT : JSON_TOKEN_END_ARRAY;
+	}
+
+	JsonToken _Value()
+	{
+		int c = _Peek();
+		if (c == ']' && _first && !_stack.empty() && _stack.back() == '[')
+		{
+			_pos++;
+			return _Close();
+		}
+		_first = false;
+		_state = _STATE_NEXT;
+		switch (c)
+		{
+		case '{':
+			_pos++;
+			return _Open('{', JSON_TOKEN_BEGIN_OBJECT);
+		case '[':
+			_pos++;
+			return _Open('[', JSON_TOKEN_BEGIN_ARRAY);
+		case '"':
+			_pos++;
+			return _ReadString() ? JSON_TOKEN_STRING : _Fail();
+		case 't':
+			return _Expect("true") ? JSON_TOKEN_TRUE : _Fail();
+		case 'f':
+			return _Expect("false") ? JSON_TOKEN_FALSE : _Fail();
+		case 'n':
+			return _Expect("null") ? JSON_TOKEN_NULL : _Fail();
+		default:
+			if (c == '-' || (c >= '0' && c <= '9'))
+				return _ReadNumber() ? JSON_TOKEN_NUMBER : _Fail();
+			return _Fail();
+		}
+	}
+
+public:
+	explicit JsonReader(std::istream & in, SizeType bufferSize = 1 << 16)
+		: _in(in), _buffer(bufferSize ? bufferSize : 1), _pos(0), _end(0),
+		_state(_STATE_VALUE), _first(false), _number(0)
+	{
+		// Skip a UTF-8 byte order mark
+		if (_Peek() == 0xEF)
+		{
+			if (!_Expect("\xEF\xBB\xBF"))
+				_state = _STATE_ERROR;
+		}
+	}
+
+	JsonReader(const JsonReader &) = delete;
+	JsonReader & operator= (const JsonReader &) = delete;
+
+	inline const std::string & String() const { return _string; }
+	inline double Number() const { return _number; }
+
+	// Next token; END once the top-level value and trailing whitespace were read
+	JsonToken Next()
+	{
+		_SkipSpace();
+		switch (_state)
+		{
+		case _STATE_NEXT:
+		{
+			if (_stack.empty())
+				return _Peek() < 0 ? JSON_TOKEN_END : _Fail();
+			int c = _Get();
+			if (c == (_stack.back() == '{' ? '}' : ']'))
+				return _Close();
+			if (c != ',')
+				return _Fail();
+			_SkipSpace();
+			if (_stack.back() == '[')
+				return _Value();
+		}
+		// The key after the comma
+		[[fallthrough]];
+		case _STATE_KEY:
+		{
+			int c = _Get();
+			if (c == '}' && _first)
+				return _Close();
+			_first = false;
+			if (c != '"' || !_ReadString())
+				return _Fail();
+			_SkipSpace();
+			if (_Get() != ':')
+				return _Fail();
+			_state = _STATE_VALUE;
+			return JSON_TOKEN_KEY;
+		}
+		case _STATE_VALUE:
+			return _Value();
+		default:
+			return JSON_TOKEN_ERROR;
+		}
+	}
+
+	// Skips the value whose first token was token, which Next just returned
+	bool Skip(JsonToken token)
+	{
+		if (token == JSON_TOKEN_ERROR || token == JSON_TOKEN_END || token == JSON_TOKEN_KEY
+			|| token == JSON_TOKEN_END_OBJECT || token == JSON_TOKEN_END_ARRAY)
+			return false;
+		if (token != JSON_TOKEN_BEGIN_OBJECT && token != JSON_TOKEN_BEGIN_ARRAY)
+			return true;
+		SizeType depth = _stack.size() - 1;
+		for (;;)
+		{
+			token = Next();
+			if (token == JSON_TOKEN_ERROR || token == JSON_TOKEN_END)
+				return false;
+			if (_stack.size() == depth)
+				return true;
+		}
+	}
+};
@@ -0,0 +1,200 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include "BitMatrix.hh"
+
+// Monotone integer priority queues for shortest paths with non-negative
+// integer weights. Both always pop the entry with the smallest key, and keys
+// pushed must not be smaller than the key last returned by Top, which
+// Dijkstra guarantees. They take the same template parameters as PriorityQueue so
+// they bind to QueueType; Container only supplies the value type, and
+// Compare is not consulted.
+
+// Default key extractor, reading the weight field of GraphDijkstraInfo
+struct HeapWeightKey
+{
+	template<class Value>
+	inline std::uint64_t operator() (const Value & value) const { return (std::uint64_t)value.weight; }
+};
+
+// Radix heap: bucket i holds the keys that first differ from the last popped
+// key at bit i - 1, bucket 0 the keys equal to it. Each entry moves to a lower
+// bucket at most 64 times, so operations are amortized O(log C).
+template<
+	class T,
+	class Container = std::vector<T>,
+	class Compare = std::less<typename Container::value_type>,
+	class KeyOf = HeapWeightKey
+>
+class RadixHeap
+{
+public:
+	typedef typename Container::value_type	ValueType;
+	typedef std::size_t						SizeType;
+	typedef std::uint64_t					KeyType;
+
+protected:
+	static constexpr SizeType _Buckets = BitWords::WordBits + 1;
+
+	std::vector<ValueType>	_buckets[_Buckets];
+	KeyType					_last;
+	SizeType				_size;
+	KeyOf					_key;
+
+	inline SizeType _BucketOf(KeyType key) const { return BitWords::BitWidth(key ^ _last); }
+
+	// Makes bucket 0 hold the minimum: the lowest non-empty bucket is split
+	// around its minimum, which becomes the new last key. Done only when the
+	// top is asked for, so pushes between a Pop and the next Top may still
+	// go below the remaining minimum.
+	void _Refill()
+	{
+		if (!_buckets[0].empty())
+			return;
+		SizeType i = 1;
+		while (_buckets[i].empty())
+			i++;
+		auto & bucket = _buckets[i];
+		_last = _key(*std::min_element(bucket.begin(), bucket.end(), [this](const ValueType & l, const ValueType & r)
+		{
+			return _key(l) < _key(r);
+		}));
+		for (auto & value : bucket)
+			_buckets[_BucketOf(_key(value))].push_back(std::move(value));
+		bucket.clear();
+	}
+
+public:
+	RadixHeap()
+		: _last(0), _size(0)
+	{ }
+
+	explicit RadixHeap(const Compare &, const KeyOf & key = KeyOf())
+		: _last(0), _size(0), _key(key)
+	{ }
+
+	inline const ValueType & Top()
+	{
+		_Refill();
+		return _buckets[0].back();
+	}
+	inline bool Empty() const { return _size == 0; }
+	inline SizeType Size() const { return _size; }
+
+	void Push(ValueType value)
+	{
+		_buckets[_BucketOf(_key(value))].push_back(std::move(value));
+		_size++;
+	}
+
+	void Pop()
+	{
+		_Refill();
+		_buckets[0].pop_back();
+		_size--;
+	}
+
+	void Clear()
+	{
+		for (auto & bucket : _buckets)
+			bucket.clear();
+		_last = 0;
+		_size = 0;
+	}
+};
+
+// Dial's bucket queue: a ring of buckets, one per key, scanned forward from the
+// last popped key. Push is O(1); Pop is O(1) plus the empty buckets skipped,
+// which is bounded by the largest edge weight. The ring grows to a power of
+// two covering the span of queued keys; pass the maximum edge weight + 1 as
+// span to size it up front.
+template<
+	class T,
+	class Container = std::vector<T>,
+	class Compare = std::less<typename Container::value_type>,
+	class KeyOf = HeapWeightKey
+>
+class BucketQueue
+{
+public:
+	typedef typename Container::value_type	ValueType;
+	typedef std::size_t						SizeType;
+	typedef std::uint64_t					KeyType;
+
+protected:
+	std::vector<std::vector<ValueType>>	_buckets;
+	KeyType								_current;
+	KeyType								_highest;
+	SizeType							_size;
+	KeyOf								_key;
+
+	inline std::vector<ValueType> & _Bucket(KeyType key) { return _buckets[(SizeType)(key & (_buckets.size() - 1))]; }
+	inline const std::vector<ValueType> & _Bucket(KeyType key) const { return _buckets[(SizeType)(key & (_buckets.size() - 1))]; }
+
+	void _Grow(KeyType span)
+	{
+		SizeType size = _buckets.size();
+		while (size < span)
+			size *= 2;
+		if (size == _buckets.size())
+			return;
+		std::vector<std::vector<ValueType>> buckets(size);
+		std::swap(_buckets, buckets);
+		for (auto & bucket : buckets)
+			for (auto & value : bucket)
+				_Bucket(_key(value)).push_back(std::move(value));
+	}
+
+	// Advances the current key to the lowest queued one
+	inline void _Advance()
+	{
+		if (_size == 0)
+			return;
+		while (_Bucket(_current).empty())
+			_current++;
+	}
+
+public:
+	BucketQueue()
+		: BucketQueue(Compare())
+	{ }
+
+	explicit BucketQueue(const Compare &, SizeType span = 64, const KeyOf & key = KeyOf())
+		: _buckets(1), _current(0), _highest(0), _size(0), _key(key)
+	{
+		_Grow(span);
+	}
+
+	inline const ValueType & Top() const { return _Bucket(_current).back(); }
+	inline bool Empty() const { return _size == 0; }
+	inline SizeType Size() const { return _size; }
+
+	void Push(ValueType value)
+	{
+		KeyType key = _key(value);
+		if (_size == 0)
+			_current = _highest = key;
+		_current = std::min<KeyType>(_current, key);
+		_highest = std::max<KeyType>(_highest, key);
+		_Grow(_highest - _current + 1);
+		_Bucket(key).push_back(std::move(value));
+		_size++;
+	}
+
+	void Pop()
+	{
+		_Bucket(_current).pop_back();
+		_size--;
+		_Advance();
+	}
+
+	void Clear()
+	{
+		for (auto & bucket : _buckets)
+			bucket.clear();
+		_current = _highest = 0;
+		_size = 0;
+	}
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include "PriorityQueue.hh"
+
+// Relaxed concurrent priority queue: factor x threads PriorityQueues, each
+// behind a try-lock. Push goes to a random heap; TryPop samples two heaps
+// and pops the better of their tops, so it returns one of the best entries
+// rather than the best. A busy heap is skipped instead of waited on, which
+// keeps threads from serializing on a single lock.
+template<
+	class T,
+	class Container = std::vector<T>,
+	class Compare = std::less<typename Container::value_type>
+>
+class MultiQueue
+{
+public:
+	typedef PriorityQueue<T, Container, Compare>	QueueType;
+	typedef typename QueueType::ValueType			ValueType;
+	typedef std::size_t								SizeType;
+
+protected:
+	// One cache line per heap so neighbouring locks do not contend
+	struct alignas(64) _Shard
+	{
+		std::atomic_flag	lock = ATOMIC_FLAG_INIT;
+		QueueType			queue;
+
+		inline bool TryLock() { return !lock.test_and_set(std::memory_order_acquire); }
+		inline void Unlock() { lock.clear(std::memory_order_release); }
+	};
+
+	std::unique_ptr<_Shard[]>	_shards;
+	SizeType					_size;
+	Compare						_comp;
+	std::atomic<SizeType>		_entries;
+
+	// xorshift state per thread, seeded from the thread id
+	static inline std::uint64_t _Random()
+	{
+		static thread_local std::uint64_t state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+	}
+
+	inline _Shard & _Pick() { return _shards[(SizeType)(_Random() % _size)]; }
+
+	// Pops the better top of a and, when it is free, b. a must be locked.
+	bool _PopBetter(_Shard & a, _Shard & b, ValueType & value)
+	{
+		_Shard * best = &a;
+		bool locked = &b != &a && b.TryLock();
+		if (locked && !b.queue.Empty() && (a.queue.Empty() || _comp(a.queue.Top(), b.queue.Top())))
+			best = &b;
+		bool found = !best->queue.Empty();
+		if (found)
+		{
+			value = std::move(best->queue.Top());
+			best->queue.Pop();
+		}
+		if (locked)
+			b.Unlock();
+		a.Unlock();
+		return found;
+	}
+
+public:
+	explicit MultiQueue(SizeType threads = std::thread::hardware_concurrency(), SizeType factor = 2, const Compare & compare = Compare())
+		: _size(std::max<SizeType>(threads * factor, 2)), _comp(compare), _entries(0)
+	{
+		_shards.reset(new _Shard[_size]);
+		for (SizeType i = 0; i < _size; i++)
+			_shards[i].queue = QueueType(compare);
+	}
+
+	MultiQueue(const MultiQueue &) = delete;
+	MultiQueue & operator= (const MultiQueue &) = delete;
+
+	// Exact only while no other thread pushes or pops
+	inline SizeType Size() const { return _entries.load(std::memory_order_relaxed); }
+	inline bool Empty() const { return Size() == 0; }
+	inline SizeType Heaps() const { return _size; }
+
+	template<class ... Args>
+	void Emplace(Args && ... args)
+	{
+		// Counted first so the count never runs below what poppers took
+		_entries.fetch_add(1, std::memory_order_release);
+		for (;;)
+		{
+			_Shard & shard = _Pick();
+			if (!shard.TryLock())
+				continue;
+			shard.queue.Emplace(std::forward<Args>(args)...);
+			shard.Unlock();
+			break;
+		}
+	}
+
+	inline void Push(const ValueType & value) { Emplace(value); }
+	inline void Push(ValueType && value) { Emplace(std::move(value)); }
+
+	// Moves one of the best entries into value. Returns false only once every
+	// heap was seen empty; entries pushed concurrently may still be missed.
+	bool TryPop(ValueType & value)
+	{
+		for (SizeType attempt = 0; attempt < _size * 2; attempt++)
+		{
+			if (_entries.load(std::memory_order_acquire) == 0)
+				return false;
+			_Shard & a = _Pick();
+			if (!a.TryLock())
+				continue;
+			if (_PopBetter(a, _Pick(), value))
+			{
+				_entries.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		// Sampling kept missing, so sweep every heap before reporting empty
+		for (SizeType i = 0; i < _size; i++)
+		{
+			_Shard & shard = _shards[i];
+			while (!shard.TryLock())
+				std::this_thread::yield();
+			if (_PopBetter(shard, shard, value))
+			{
+				_entries.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Must not run concurrently with anything else
+	void Reserve(SizeType size)
+	{
+		for (SizeType i = 0; i < _size; i++)
+			_shards[i].queue.Reserve(size / _size + 1);
+	}
+
+	// Must not run concurrently with anything else
+	void Clear()
+	{
+		for (SizeType i = 0; i < _size; i++)
+			_shards[i].queue.Clear();
+		_entries.store(0, std::memory_order_relaxed);
+	}
+};
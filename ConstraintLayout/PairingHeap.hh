@@ -0,0 +1,292 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+// Pairing heap ordered like PriorityQueue (the top is the greatest entry
+// under Compare) with O(1) Push and Meld, amortized O(log n) Pop and
+// handle-based DecreaseKey. Nodes come from slabs of SlabNodes nodes that
+// are recycled through a free list, so pushes do not allocate once the heap
+// has warmed up; Meld adopts the other heap's slabs along with its nodes.
+// Container only supplies the value type, so the heap binds to QueueType.
+template<
+	class T,
+	class Container = std::vector<T>,
+	class Compare = std::less<typename Container::value_type>
+>
+class PairingHeap
+{
+public:
+	typedef Compare								ValueCompare;
+	typedef typename Container::value_type		ValueType;
+	typedef std::size_t							SizeType;
+	typedef const ValueType &					ConstReference;
+
+	static constexpr SizeType SlabNodes = 256;
+
+protected:
+	struct _Node
+	{
+		ValueType	value;
+		_Node *		child;
+		_Node *		sibling;
+		// Parent for a leftmost child, left sibling otherwise
+		_Node *		prev;
+
+		template<class ... Args>
+		_Node(Args && ... args)
+			: value(std::forward<Args>(args)...), child(nullptr), sibling(nullptr), prev(nullptr)
+		{ }
+	};
+
+	struct _FreeNode
+	{
+		_FreeNode * next;
+	};
+
+	struct _Slab
+	{
+		std::unique_ptr<_Slab> next;
+		typename std::aligned_storage<sizeof(_Node), alignof(_Node)>::type nodes[SlabNodes];
+	};
+
+public:
+	// Stays valid until the entry is popped
+	typedef _Node * Handle;
+
+protected:
+	Compare					_comp;
+	_Node *					_root;
+	SizeType				_size;
+	std::unique_ptr<_Slab>	_slabs;
+	_Slab *					_slabsTail;
+	SizeType				_slabUsed;
+	_FreeNode *				_free;
+	_FreeNode *				_freeTail;
+	std::vector<_Node *>	_pairs;
+
+	template<class ... Args>
+	_Node * _Allocate(Args && ... args)
+	{
+		void * storage;
+		if (_free)
+		{
+			storage = _free;
+			_free = _free->next;
+			if (!_free)
+				_freeTail = nullptr;
+		}
+		else
+		{
+			if (!_slabs || _slabUsed == SlabNodes)
+			{
+				std::unique_ptr<_Slab> slab(new _Slab);
+				slab->next = std::move(_slabs);
+				if (!slab->next)
+					_slabsTail = slab.get();
+				_slabs = std::move(slab);
+				_slabUsed = 0;
+			}
+			storage = &_slabs->nodes[_slabUsed++];
+		}
+		return new (storage) _Node(std::forward<Args>(args)...);
+	}
+
+	inline void _PushFree(void * storage)
+	{
+		_FreeNode * link = new (storage) _FreeNode{ nullptr };
+		if (_freeTail)
+			_freeTail->next = link;
+		else
+			_free = link;
+		_freeTail = link;
+	}
+
+	// Destroys the value; the node memory goes to the free list
+	inline void _Release(_Node * node)
+	{
+		node->~_Node();
+		_PushFree(node);
+	}
+
+	// Links two roots; the lower one becomes the leftmost child of the other
+	inline _Node * _Link(_Node * l, _Node * r)
+	{
+		if (!l)
+			return r;
+		if (!r)
+			return l;
+		if (_comp(l->value, r->value))
+			std::swap(l, r);
+		r->prev = l;
+		r->sibling = l->child;
+		if (l->child)
+			l->child->prev = r;
+		l->child = r;
+		l->sibling = nullptr;
+		l->prev = nullptr;
+		return l;
+	}
+
+	// Two-pass pairing of a child list into a single root
+	_Node * _Merge(_Node * first)
+	{
+		_pairs.clear();
+		while (first)
+		{
+			_Node * a = first;
+			_Node * b = a->sibling;
+			first = b ? b->sibling : nullptr;
+			a->sibling = a->prev = nullptr;
+			if (b)
+				b->sibling = b->prev = nullptr;
+			_pairs.push_back(_Link(a, b));
+		}
+		_Node * rtn = nullptr;
+		for (auto it = _pairs.rbegin(); it != _pairs.rend(); ++it)
+			rtn = _Link(*it, rtn);
+		return rtn;
+	}
+
+	// Detaches a non-root node, with its subtree, from its parent's child list
+	inline void _Cut(_Node * node)
+	{
+		if (node->prev->child == node)
+			node->prev->child = node->sibling;
+		else
+			node->prev->sibling = node->sibling;
+		if (node->sibling)
+			node->sibling->prev = node->prev;
+		node->sibling = node->prev = nullptr;
+	}
+
+public:
+	PairingHeap()
+		: PairingHeap(Compare()) { }
+
+	explicit PairingHeap(const Compare & compare)
+		: _comp(compare), _root(nullptr), _size(0), _slabsTail(nullptr), _slabUsed(0),
+		_free(nullptr), _freeTail(nullptr)
+	{ }
+
+	PairingHeap(const PairingHeap &) = delete;
+	PairingHeap & operator= (const PairingHeap &) = delete;
+
+	PairingHeap(PairingHeap && other)
+		: PairingHeap(other._comp)
+	{
+		Meld(other);
+	}
+
+	PairingHeap & operator= (PairingHeap && other)
+	{
+		if (this != &other)
+		{
+			Clear();
+			Meld(other);
+		}
+		return *this;
+	}
+
+	~PairingHeap()
+	{
+		Clear();
+		// Unlink iteratively so long slab chains do not recurse
+		while (_slabs)
+			_slabs = std::move(_slabs->next);
+	}
+
+	inline ConstReference Top() const { return _root->value; }
+	inline Handle TopHandle() const { return _root; }
+	inline bool Empty() const { return _size == 0; }
+	inline SizeType Size() const { return _size; }
+
+	template<class ... Args>
+	Handle Emplace(Args && ... args)
+	{
+		_Node * node = _Allocate(std::forward<Args>(args)...);
+		_root = _Link(_root, node);
+		_size++;
+		return node;
+	}
+
+	inline Handle Push(const ValueType & value) { return Emplace(value); }
+	inline Handle Push(ValueType && value) { return Emplace(std::move(value)); }
+
+	void Pop()
+	{
+		_Node * top = _root;
+		_root = _Merge(top->child);
+		_size--;
+		_Release(top);
+	}
+
+	// Gives the entry a value of at least its current priority
+	void DecreaseKey(Handle handle, ValueType value)
+	{
+		handle->value = std::move(value);
+		if (handle == _root)
+			return;
+		_Cut(handle);
+		_root = _Link(_root, handle);
+	}
+
+	// Moves every entry of other into this heap in O(1); other is left empty.
+	// Handles into other stay valid and now refer to this heap.
+	void Meld(PairingHeap & other)
+	{
+		if (this == &other)
+			return;
+		_root = _Link(_root, other._root);
+		_size += other._size;
+		other._root = nullptr;
+		other._size = 0;
+
+		// The other slabs go behind ours, and the unused tail of its current slab joins the free list
+		if (other._slabs)
+		{
+			for (SizeType i = other._slabUsed; i < SlabNodes; i++)
+				other._PushFree(&other._slabs->nodes[i]);
+			if (_slabs)
+				_slabsTail->next = std::move(other._slabs);
+			else
+			{
+				_slabs = std::move(other._slabs);
+				_slabUsed = SlabNodes;
+			}
+			_slabsTail = other._slabsTail;
+			other._slabsTail = nullptr;
+			other._slabUsed = 0;
+		}
+		if (other._free)
+		{
+			if (_freeTail)
+				_freeTail->next = other._free;
+			else
+				_free = other._free;
+			_freeTail = other._freeTail;
+			other._free = other._freeTail = nullptr;
+		}
+	}
+
+	// Destroys every entry but keeps the slabs for reuse
+	void Clear()
+	{
+		if (_root)
+		{
+			_pairs.clear();
+			_pairs.push_back(_root);
+			while (!_pairs.empty())
+			{
+				_Node * node = _pairs.back(); _pairs.pop_back();
+				for (_Node * i = node->child; i; i = i->sibling)
+					_pairs.push_back(i);
+				_Release(node);
+			}
+		}
+		_root = nullptr;
+		_size = 0;
+	}
+};
@@ -1,11 +1,177 @@
 #pragma once
 #include <vector>
 #include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PRIORITYQUEUE_SSE2
+#endif
+#if defined(__SSE4_1__) || defined(__AVX__)
+#include <smmintrin.h>
+#define PRIORITYQUEUE_SSE41
+#endif
+
+// Number of children per heap node, passed as a type so that PriorityQueue
+// still binds to template<class, class ...> class QueueType parameters
+template<std::size_t N>
+struct HeapArity : std::integral_constant<std::size_t, N>
+{ };
+
+// Vectorized selection of the top child among Arity keys, either contiguous
+// (Best) or read one by one through key(i) (BestOf).
+// Enabled for float and int32_t keys ordered by std::less or std::greater
+// with an arity that is a multiple of 4; ties resolve to the first child,
+// as in the scalar loop.
+template<class T, class Compare, std::size_t Arity>
+struct HeapChildSelect
+{
+	static constexpr bool Enabled = false;
+	static inline std::size_t Best(const T *) { return 0; }
+	template<class Key>
+	static inline std::size_t BestOf(const Key &) { return 0; }
+};
+
+#if defined(PRIORITYQUEUE_SSE2)
+struct _HeapLanesF32
+{
+	typedef __m128 Vector;
+	static inline Vector Load(const float * p) { return _mm_loadu_ps(p); }
+	static inline Vector Set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+	static inline Vector Max(Vector l, Vector r) { return _mm_max_ps(l, r); }
+	static inline Vector Min(Vector l, Vector r) { return _mm_min_ps(l, r); }
+	static inline Vector Swap1(Vector v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)); }
+	static inline Vector Swap2(Vector v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)); }
+	static inline int Equal(Vector l, Vector r) { return _mm_movemask_ps(_mm_cmpeq_ps(l, r)); }
+};
+
+struct _HeapLanesI32
+{
+	typedef __m128i Vector;
+	static inline Vector Load(const std::int32_t * p) { return _mm_loadu_si128((const __m128i *)p); }
+	static inline Vector Set(std::int32_t a, std::int32_t b, std::int32_t c, std::int32_t d) { return _mm_setr_epi32(a, b, c, d); }
+#if defined(PRIORITYQUEUE_SSE41)
+	static inline Vector Max(Vector l, Vector r) { return _mm_max_epi32(l, r); }
+	static inline Vector Min(Vector l, Vector r) { return _mm_min_epi32(l, r); }
+#else
+	// SSE2 has no 32-bit min and max, so blend on a comparison
+	static inline Vector Select(Vector mask, Vector l, Vector r) { return _mm_or_si128(_mm_and_si128(mask, l), _mm_andnot_si128(mask, r)); }
+	static inline Vector Max(Vector l, Vector r) { return Select(_mm_cmpgt_epi32(l, r), l, r); }
+	static inline Vector Min(Vector l, Vector r) { return Select(_mm_cmplt_epi32(l, r), l, r); }
+#endif
+	static inline Vector Swap1(Vector v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)); }
+	static inline Vector Swap2(Vector v) { return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)); }
+	static inline int Equal(Vector l, Vector r) { return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(l, r))); }
+};
+#endif
+
+// load(i) yields the keys i .. i + 3; each group is loaded once and kept in registers
+template<class Lanes, bool Maximum, std::size_t Arity, class Load>
+inline std::size_t _HeapSelect(const Load & load)
+{
+	typedef typename Lanes::Vector Vector;
+	auto pick = [](Vector l, Vector r) { return Maximum ? Lanes::Max(l, r) : Lanes::Min(l, r); };
+	Vector keys[Arity / 4];
+	for (std::size_t i = 0; i < Arity / 4; i++)
+		keys[i] = load(i * 4);
+	Vector best = keys[0];
+	for (std::size_t i = 1; i < Arity / 4; i++)
+		best = pick(best, keys[i]);
+	best = pick(best, Lanes::Swap1(best));
+	best = pick(best, Lanes::Swap2(best));
+	// Index of the lowest set bit by de Bruijn multiplication, since a branch
+	// per group mispredicts about as often as the scalar loop would
+	static_assert(Arity <= 32, "Child masks are 32 bits wide");
+	static const unsigned char lowest[32] = {
+		0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+		31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9 };
+	std::uint32_t mask = 0;
+	for (std::size_t i = 0; i < Arity / 4; i++)
+		mask |= (std::uint32_t)Lanes::Equal(keys[i], best) << (i * 4);
+	return lowest[((mask & (0u - mask)) * 0x077CB531u) >> 27];
+}
+
+template<class Lanes, bool Maximum, std::size_t Arity, class T>
+inline std::size_t _HeapSelectBest(const T * keys)
+{
+	return _HeapSelect<Lanes, Maximum, Arity>([keys](std::size_t i) { return Lanes::Load(keys + i); });
+}
+
+template<class Lanes, bool Maximum, std::size_t Arity, class Key>
+inline std::size_t _HeapSelectBestOf(const Key & key)
+{
+	return _HeapSelect<Lanes, Maximum, Arity>([&key](std::size_t i) { return Lanes::Set(key(i), key(i + 1), key(i + 2), key(i + 3)); });
+}
+
+#if defined(PRIORITYQUEUE_SSE2)
+template<std::size_t Arity>
+struct HeapChildSelect<float, std::less<float>, Arity>
+{
+	static constexpr bool Enabled = Arity % 4 == 0;
+	static inline std::size_t Best(const float * keys) { return _HeapSelectBest<_HeapLanesF32, true, Arity>(keys); }
+	template<class Key>
+	static inline std::size_t BestOf(const Key & key) { return _HeapSelectBestOf<_HeapLanesF32, true, Arity>(key); }
+};
+template<std::size_t Arity>
+struct HeapChildSelect<float, std::greater<float>, Arity>
+{
+	static constexpr bool Enabled = Arity % 4 == 0;
+	static inline std::size_t Best(const float * keys) { return _HeapSelectBest<_HeapLanesF32, false, Arity>(keys); }
+	template<class Key>
+	static inline std::size_t BestOf(const Key & key) { return _HeapSelectBestOf<_HeapLanesF32, false, Arity>(key); }
+};
+
+template<std::size_t Arity>
+struct HeapChildSelect<std::int32_t, std::less<std::int32_t>, Arity>
+{
+	static constexpr bool Enabled = Arity % 4 == 0;
+	static inline std::size_t Best(const std::int32_t * keys) { return _HeapSelectBest<_HeapLanesI32, true, Arity>(keys); }
+	template<class Key>
+	static inline std::size_t BestOf(const Key & key) { return _HeapSelectBestOf<_HeapLanesI32, true, Arity>(key); }
+};
+template<std::size_t Arity>
+struct HeapChildSelect<std::int32_t, std::greater<std::int32_t>, Arity>
+{
+	static constexpr bool Enabled = Arity % 4 == 0;
+	static inline std::size_t Best(const std::int32_t * keys) { return _HeapSelectBest<_HeapLanesI32, false, Arity>(keys); }
+	template<class Key>
+	static inline std::size_t BestOf(const Key & key) { return _HeapSelectBestOf<_HeapLanesI32, false, Arity>(key); }
+};
+#endif
+
+// Comparators that order entries by a single field can declare it,
+//		template<class T> static inline auto HeapKey(const T & value) { return value.weight; }
+//		static constexpr bool HeapKeyGreater = true;		// compares keys with > rather than <
+// so full nodes of a d-ary heap gather the keys of their children and pick
+// among them with HeapChildSelect, even though the entries are not plain keys.
+template<class T, class Compare, std::size_t Arity, class = void>
+struct HeapKeySelect
+{
+	static constexpr bool Enabled = false;
+};
+
+template<class T, class Compare, std::size_t Arity>
+struct HeapKeySelect<T, Compare, Arity, std::void_t<decltype(Compare::HeapKey(std::declval<const T &>())), decltype(Compare::HeapKeyGreater)>>
+{
+	typedef typename std::decay<decltype(Compare::HeapKey(std::declval<const T &>()))>::type KeyType;
+	typedef typename std::conditional<Compare::HeapKeyGreater, std::greater<KeyType>, std::less<KeyType>>::type KeyCompare;
+	typedef HeapChildSelect<KeyType, KeyCompare, Arity> Select;
+
+	static constexpr bool Enabled = Select::Enabled;
+};
+
+// Max-heap with respect to Compare, like std::priority_queue.
+// Arity sets the number of children per node: wider nodes make the tree
+// shallower and keep siblings adjacent, which pays off for push-heavy use.
 template<
 	class T,
 	class Container = std::vector<T>,
-	class Compare = std::less<typename Container::value_type>
+	class Compare = std::less<typename Container::value_type>,
+	class Arity = HeapArity<2>
 >
 class PriorityQueue
 {
@@ -21,67 +187,134 @@ protected:
 	Container	_c;
 	Compare		_comp;
 
-	inline SizeType _Parent(SizeType idx) { return (idx - 1) / 2; }
-	inline SizeType _Left(SizeType idx) { return idx * 2 + 1; }
-	inline SizeType _Right(SizeType idx) { return idx * 2 + 2; }
+	// Bounds-checked only in debug builds; the sift loops keep indices in range
+#if defined(_DEBUG)
+	inline Reference _At(SizeType idx) { return _c.at(idx); }
+#else
+	inline Reference _At(SizeType idx) { return _c[idx]; }
+#endif
 
-	inline void _Heapify(SizeType idx)
+	static constexpr SizeType _Arity = Arity::value;
+	static_assert(_Arity >= 2, "Heap arity must be at least 2");
+
+	inline SizeType _Parent(SizeType idx) { return (idx - 1) / _Arity; }
+	inline SizeType _Child(SizeType idx) { return idx * _Arity + 1; }
+
+	// Top-priority child among count children starting at first
+	inline SizeType _BestChild(SizeType first, SizeType count)
 	{
-		SizeType l = _Left(idx), r = _Right(idx), t = idx;
-		for (;;)
+		typedef HeapChildSelect<ValueType, Compare, _Arity> Select;
+		typedef HeapKeySelect<ValueType, Compare, _Arity> KeySelect;
+		if constexpr (Select::Enabled && std::is_same<Container, std::vector<ValueType>>::value)
 		{
-			SizeType size = _c.size();
-			if (l < size && _comp(_c.at(idx), _c.at(l)))
-				t = l;
-			if (r < size && _comp(_c.at(t), _c.at(r)))
-				t = r;
-			if (t != idx)
+			if (count == _Arity)
+				return first + (SizeType)Select::Best(_c.data() + first);
+		}
+		else if constexpr (KeySelect::Enabled)
+		{
+			if (count == _Arity)
 			{
-				std::swap(_c.at(t), _c.at(idx));
-				idx = t;
-				l = _Left(idx), r = _Right(idx);
+				// Keys are read one by one, so the container need not be contiguous
+				return first + (SizeType)KeySelect::Select::BestOf(
+					[this, first](std::size_t i) { return (typename KeySelect::KeyType)Compare::HeapKey(_At(first + (SizeType)i)); });
 			}
-			else
+		}
+		SizeType best = first;
+		for (SizeType i = first + 1; i < first + count; i++)
+			if (_comp(_At(best), _At(i)))
+				best = i;
+		return best;
+	}
+
+	// The sifts lift the entry out and move a hole along its path,
+	// so each level costs one move instead of a swap
+	inline void _Heapify(SizeType idx)
+	{
+		SizeType size = _c.size();
+		if (_Child(idx) >= size)
+			return;
+		ValueType value = std::move(_At(idx));
+		for (;;)
+		{
+			SizeType first = _Child(idx);
+			if (first >= size)
+				break;
+			SizeType t = _BestChild(first, std::min<SizeType>(_Arity, size - first));
+			if (!_comp(value, _At(t)))
 				break;
+			_At(idx) = std::move(_At(t));
+			idx = t;
 		}
+		_At(idx) = std::move(value);
 	}
 
 	inline void _RHeapify(SizeType idx)
 	{
-		SizeType p = _Parent(idx);
-		while (idx && _comp(_c.at(p), _c.at(idx)))
+		if (idx == 0 || !_comp(_At(_Parent(idx)), _At(idx)))
+			return;
+		ValueType value = std::move(_At(idx));
+		do
 		{
-			std::swap(_c.at(p), _c.at(idx));
+			SizeType p = _Parent(idx);
+			_At(idx) = std::move(_At(p));
 			idx = p;
-			p = _Parent(idx);
-		}
+		} while (idx && _comp(_At(_Parent(idx)), value));
+		_At(idx) = std::move(value);
+	}
+
+	// Floyd's bottom-up construction, O(n)
+	void _Build()
+	{
+		SizeType size = _c.size();
+		if (size < 2)
+			return;
+		for (SizeType i = _Parent(size - 1) + 1; i-- > 0;)
+			_Heapify(i);
 	}
 
 public:
 	PriorityQueue()
-		: PriorityQueue(Compare(), Container()) { }
+		: _c(), _comp() { }
 
 	explicit PriorityQueue(const Compare & compare)
-		: PriorityQueue(compare, Container()) { }
+		: _c(), _comp(compare) { }
 
 	PriorityQueue(
 		const Compare & compare,
 		const Container & cont)
-		: _comp(compare), _c()
+		: _c(cont), _comp(compare)
+	{
+		_Build();
+	}
+
+	PriorityQueue(
+		const Compare & compare,
+		Container && cont)
+		: _c(std::move(cont)), _comp(compare)
 	{
-		for (auto & i : cont) Push(i);
+		_Build();
+	}
+
+	template<class InputIterator>
+	PriorityQueue(
+		InputIterator first,
+		InputIterator last,
+		const Compare & compare = Compare())
+		: _c(first, last), _comp(compare)
+	{
+		_Build();
 	}
 
 	PriorityQueue(
 		const PriorityQueue & other
 	)
-		: _comp(other._comp), _c(other._c)
+		: _c(other._c), _comp(other._comp)
 	{ }
 
 	PriorityQueue(
 		PriorityQueue && other
 	)
-		: _comp(other._comp), _c(std::move(other._c))
+		: _c(std::move(other._c)), _comp(std::move(other._comp))
 	{ }
 
 	~PriorityQueue() { }
@@ -96,7 +329,7 @@ public:
 	PriorityQueue & operator= (PriorityQueue && other)
 	{
 		_c = std::move(other._c);
-		_comp = other._comp;
+		_comp = std::move(other._comp);
 		return *this;
 	}
 
@@ -117,20 +350,43 @@ public:
 	}
 	void Pop()
 	{
-		_c.front() = _c.back();
+		if (_c.size() > 1)
+			_c.front() = std::move(_c.back());
 		_c.pop_back();
 		_Heapify(0);
 	}
 
+	// Constructs one entry in place from args
 	template<class ... Args>
-	void Emplace(Args && ... args);
-
-	template<class Arg>
-	inline void Emplace(Arg && arg) { Push(std::move(arg)); }
-
-	template<class Arg, class ... Args>
-	inline void Emplace(Arg && arg, Args && ... args)
+	void Emplace(Args && ... args)
 	{
-		Push(std::move(arg)); Emplace(std::move(args)...);
+		_c.emplace_back(std::forward<Args>(args)...);
+		_RHeapify(_c.size() - 1);
 	}
+
+	inline void Reserve(SizeType size) { _c.reserve(size); }
+	inline SizeType Capacity() const { return _c.capacity(); }
+
+	// Drops every entry but keeps the buffer, so the queue can serve the next search
+	inline void Clear() { _c.clear(); }
 };
+
+// Adapter for the QueueType parameter of Dijkstra and DirectedGraph::Dijkstra,
+// e.g. Dijkstra<DaryHeap<4>::Type>(graph, source, destination)
+template<std::size_t N>
+struct DaryHeap
+{
+	template<
+		class T,
+		class Container = std::vector<T>,
+		class Compare = std::less<typename Container::value_type>
+	>
+	using Type = PriorityQueue<T, Container, Compare, HeapArity<N>>;
+};
+
+// Deduces the comparator type, so lambdas are called directly rather than through std::function
+template<class T, class Compare>
+inline PriorityQueue<T, std::vector<T>, Compare> MakePriorityQueue(const Compare & compare)
+{
+	return PriorityQueue<T, std::vector<T>, Compare>(compare);
+}
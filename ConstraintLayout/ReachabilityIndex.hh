@@ -0,0 +1,234 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include "BitMatrix.hh"
+#include "DirectedGraph.hh"
+
+enum ReachabilityMode
+{
+	REACHABILITY_AUTO,
+	REACHABILITY_BITSET,
+	REACHABILITY_INTERVAL
+};
+
+// Search state of an interval-mode query. Marks are epoch stamps, so one
+// scratch can serve any number of queries, and indices, without clearing.
+template<class SizeType>
+struct ReachabilityScratch
+{
+	std::vector<SizeType>	mark;
+	SizeType				epoch = 0;
+	std::vector<SizeType>	stack;
+
+	// Starts a query over size groups
+	void Reset(SizeType size)
+	{
+		if (mark.size() < size)
+			mark.resize(size, 0);
+		if (++epoch == 0)
+		{
+			std::fill(mark.begin(), mark.end(), SizeType(0));
+			epoch = 1;
+		}
+		stack.clear();
+	}
+};
+
+// Answers "does a path from u to v exist" over the condensation of a graph.
+// In bitset mode every group owns a row of its transitive closure, so a query
+// is a single bit test. In interval mode every group keeps a spanning-tree
+// interval, which proves reachability, and a GRAIL-style label, which refutes
+// it; only queries that neither decides fall back to a pruned search.
+// Queries only read the index; the search state lives in a
+// ReachabilityScratch, per thread unless the caller supplies one.
+template<class Graph>
+class ReachabilityIndex
+{
+public:
+	typedef typename Graph::IndexType		IndexType;
+	typedef ReachabilityScratch<IndexType>	ScratchType;
+
+	// Largest number of groups stored as a dense closure in REACHABILITY_AUTO (32 MiB of rows)
+	static constexpr std::size_t DenseLimit = 16384;
+
+protected:
+	ReachabilityMode					_mode;
+	std::vector<IndexType>				_group;
+	std::vector<std::vector<IndexType>>	_successors;
+	BitMatrix							_closure;
+
+	std::vector<IndexType>				_pre;
+	std::vector<IndexType>				_post;
+	std::vector<IndexType>				_low;
+
+	void _BuildSuccessors(Graph & graph, IndexType size)
+	{
+		_successors.assign(size, std::vector<IndexType>());
+		std::vector<IndexType> last(size, size);
+		for (IndexType v = 0; v < graph.VerticesSize(); v++)
+		{
+			IndexType from = _group[v];
+			for (auto & edge : graph.EdgesFrom(v))
+			{
+				IndexType to = _group[edge.destination];
+				if (to != from && last[to] != from)
+				{
+					last[to] = from;
+					_successors[from].push_back(to);
+				}
+			}
+		}
+	}
+
+	// Groups are in topological order, so walking them backwards finishes
+	// every successor row before it is OR-ed into its predecessors
+	void _BuildClosure(IndexType size)
+	{
+		_closure = BitMatrix(size, size);
+		for (IndexType g = size; g-- > 0;)
+		{
+			_closure.Set(g, g);
+			for (auto s : _successors[g])
+				_closure.OrRow(g, s);
+		}
+	}
+
+	void _BuildIntervals(IndexType size)
+	{
+		_pre.assign(size, 0);
+		_post.assign(size, 0);
+		_low.assign(size, 0);
+		std::vector<bool> visited(size);
+		std::vector<bool> hasParent(size);
+		for (auto & successors : _successors)
+			for (auto s : successors)
+				hasParent[s] = true;
+
+		std::vector<std::pair<IndexType, IndexType>> stack;
+		IndexType pre = 0, post = 0;
+		auto visit = [&](IndexType root)
+		{
+			if (visited[root])
+				return;
+			visited[root] = true;
+			_pre[root] = pre++;
+			stack.push_back({ root, 0 });
+			while (!stack.empty())
+			{
+				auto & top = stack.back();
+				IndexType g = top.first;
+				if (top.second < _successors[g].size())
+				{
+					IndexType s = _successors[g][top.second++];
+					if (!visited[s])
+					{
+						visited[s] = true;
+						_pre[s] = pre++;
+						stack.push_back({ s, 0 });
+					}
+					continue;
+				}
+				_post[g] = post++;
+				IndexType low = _post[g];
+				for (auto s : _successors[g])
+					if (_low[s] < low)
+						low = _low[s];
+				_low[g] = low;
+				stack.pop_back();
+			}
+		};
+		for (IndexType g = 0; g < size; g++)
+			if (!hasParent[g])
+				visit(g);
+		for (IndexType g = 0; g < size; g++)
+			visit(g);
+	}
+
+	// Tree containment proves a path, label non-containment refutes one
+	inline bool _TreeContains(IndexType from, IndexType to) const
+	{
+		return _pre[from] <= _pre[to] && _post[to] <= _post[from];
+	}
+	inline bool _MayReach(IndexType from, IndexType to) const
+	{
+		return _low[from] <= _low[to] && _post[to] <= _post[from];
+	}
+
+	bool _IntervalReachable(IndexType from, IndexType to, ScratchType & scratch) const
+	{
+		if (_TreeContains(from, to))
+			return true;
+		if (!_MayReach(from, to))
+			return false;
+
+		scratch.Reset(GroupsSize());
+		scratch.stack.push_back(from);
+		scratch.mark[from] = scratch.epoch;
+		while (!scratch.stack.empty())
+		{
+			IndexType g = scratch.stack.back(); scratch.stack.pop_back();
+			for (auto s : _successors[g])
+			{
+				if (s == to || _TreeContains(s, to))
+					return true;
+				if (scratch.mark[s] != scratch.epoch && _MayReach(s, to))
+				{
+					scratch.mark[s] = scratch.epoch;
+					scratch.stack.push_back(s);
+				}
+			}
+		}
+		return false;
+	}
+
+public:
+	ReachabilityIndex()
+		: _mode(REACHABILITY_BITSET)
+	{ }
+
+	explicit ReachabilityIndex(Graph & graph, ReachabilityMode mode = REACHABILITY_AUTO)
+	{
+		auto groups = graph.StronglyConnectedGroups();
+		_group.assign(groups.group.begin(), groups.group.end());
+		_BuildSuccessors(graph, groups.size);
+
+		if (mode == REACHABILITY_AUTO)
+			mode = (std::size_t)groups.size <= DenseLimit ? REACHABILITY_BITSET : REACHABILITY_INTERVAL;
+		_mode = mode;
+
+		if (_mode == REACHABILITY_BITSET)
+			_BuildClosure(groups.size);
+		else
+			_BuildIntervals(groups.size);
+	}
+
+	inline ReachabilityMode Mode() const { return _mode; }
+	inline IndexType GroupsSize() const { return (IndexType)_successors.size(); }
+	inline IndexType GroupOf(IndexType vertex) const { return _group[vertex]; }
+
+	// Every vertex reaches itself. Safe to call from several threads as long
+	// as each passes its own scratch.
+	bool Reachable(IndexType from, IndexType to, ScratchType & scratch) const
+	{
+		IndexType f = _group[from], t = _group[to];
+		if (f == t)
+			return true;
+		// Edges only go from lower to higher groups
+		if (f > t)
+			return false;
+		if (_mode == REACHABILITY_BITSET)
+			return _closure.Test(f, t);
+		return _IntervalReachable(f, t, scratch);
+	}
+
+	// Uses a scratch owned by the calling thread
+	inline bool Reachable(IndexType from, IndexType to) const
+	{
+		static thread_local ScratchType scratch;
+		return Reachable(from, to, scratch);
+	}
+
+	// Whether adding the edge from -> to would close a cycle
+	inline bool CreatesCycle(IndexType from, IndexType to) const { return Reachable(to, from); }
+};
@@ -0,0 +1,253 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <initializer_list>
+#include <type_traits>
+
+// Vector that keeps up to N elements inline and only allocates beyond that
+template<class T, std::size_t N>
+class SmallVector
+{
+public:
+	typedef T									value_type;
+	typedef std::size_t							size_type;
+	typedef std::ptrdiff_t						difference_type;
+	typedef T &									reference;
+	typedef const T &							const_reference;
+	typedef T *									pointer;
+	typedef const T *							const_pointer;
+	typedef T *									iterator;
+	typedef const T *							const_iterator;
+	typedef std::reverse_iterator<iterator>			reverse_iterator;
+	typedef std::reverse_iterator<const_iterator>	const_reverse_iterator;
+
+protected:
+	T *			_data;
+	size_type	_size;
+	size_type	_capacity;
+	typename std::aligned_storage<sizeof(T) * (N ? N : 1), alignof(T)>::type _inline;
+
+	inline T * _Inline() { return reinterpret_cast<T *>(&_inline); }
+	inline bool _IsInline() const { return _data == reinterpret_cast<const T *>(&_inline); }
+
+	inline size_type _NextCapacity(size_type capacity) const
+	{
+		return capacity < _capacity * 2 ? _capacity * 2 : capacity;
+	}
+
+	// Moves the elements into data, which holds capacity elements, and takes it over
+	void _Adopt(T * data, size_type capacity)
+	{
+		for (size_type i = 0; i < _size; i++)
+		{
+			::new (static_cast<void *>(data + i)) T(std::move_if_noexcept(_data[i]));
+			_data[i].~T();
+		}
+		if (!_IsInline())
+			std::allocator<T>().deallocate(_data, _capacity);
+		_data = data;
+		_capacity = capacity;
+	}
+
+	void _Grow(size_type capacity)
+	{
+		if (capacity <= _capacity)
+			return;
+		capacity = _NextCapacity(capacity);
+		_Adopt(std::allocator<T>().allocate(capacity), capacity);
+	}
+
+	void _Release()
+	{
+		clear();
+		if (!_IsInline())
+			std::allocator<T>().deallocate(_data, _capacity);
+		_data = _Inline();
+		_capacity = N;
+	}
+
+	void _Steal(SmallVector & other)
+	{
+		if (other._IsInline())
+		{
+			for (size_type i = 0; i < other._size; i++)
+				::new (static_cast<void *>(_data + i)) T(std::move(other._data[i]));
+			_size = other._size;
+			other.clear();
+		}
+		else
+		{
+			_data = other._data;
+			_size = other._size;
+			_capacity = other._capacity;
+			other._data = other._Inline();
+			other._size = 0;
+			other._capacity = N;
+		}
+	}
+
+public:
+	SmallVector()
+		: _data(_Inline()), _size(0), _capacity(N)
+	{ }
+
+	explicit SmallVector(size_type count, const T & value = T())
+		: SmallVector()
+	{
+		_Grow(count);
+		for (; _size < count; _size++)
+			::new (static_cast<void *>(_data + _size)) T(value);
+	}
+
+	template<class InputIt, class = typename std::iterator_traits<InputIt>::iterator_category>
+	SmallVector(InputIt first, InputIt last)
+		: SmallVector()
+	{
+		for (; first != last; ++first)
+			push_back(*first);
+	}
+
+	SmallVector(std::initializer_list<T> list)
+		: SmallVector(list.begin(), list.end())
+	{ }
+
+	SmallVector(const SmallVector & other)
+		: SmallVector(other.begin(), other.end())
+	{ }
+
+	SmallVector(SmallVector && other) noexcept
+		: SmallVector()
+	{
+		_Steal(other);
+	}
+
+	~SmallVector() { _Release(); }
+
+	SmallVector & operator= (const SmallVector & other)
+	{
+		if (this != &other)
+		{
+			clear();
+			_Grow(other._size);
+			for (auto & i : other)
+				push_back(i);
+		}
+		return *this;
+	}
+
+	SmallVector & operator= (SmallVector && other) noexcept
+	{
+		if (this != &other)
+		{
+			_Release();
+			_Steal(other);
+		}
+		return *this;
+	}
+
+	inline iterator begin() { return _data; }
+	inline iterator end() { return _data + _size; }
+	inline const_iterator begin() const { return _data; }
+	inline const_iterator end() const { return _data + _size; }
+	inline const_iterator cbegin() const { return _data; }
+	inline const_iterator cend() const { return _data + _size; }
+	inline reverse_iterator rbegin() { return reverse_iterator(end()); }
+	inline reverse_iterator rend() { return reverse_iterator(begin()); }
+	inline const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	inline const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	inline size_type size() const { return _size; }
+	inline size_type capacity() const { return _capacity; }
+	inline bool empty() const { return _size == 0; }
+	inline T * data() { return _data; }
+	inline const T * data() const { return _data; }
+
+	inline reference operator[] (size_type idx) { return _data[idx]; }
+	inline const_reference operator[] (size_type idx) const { return _data[idx]; }
+	inline reference at(size_type idx)
+	{
+		if (idx >= _size)
+			throw std::out_of_range("SmallVector::at");
+		return _data[idx];
+	}
+	inline const_reference at(size_type idx) const
+	{
+		if (idx >= _size)
+			throw std::out_of_range("SmallVector::at");
+		return _data[idx];
+	}
+	inline reference front() { return _data[0]; }
+	inline const_reference front() const { return _data[0]; }
+	inline reference back() { return _data[_size - 1]; }
+	inline const_reference back() const { return _data[_size - 1]; }
+
+	inline void reserve(size_type capacity) { _Grow(capacity); }
+
+	template<class ... Args>
+	reference emplace_back(Args && ... args)
+	{
+		if (_size == _capacity)
+		{
+			// args may refer to an element, so the new one is built before the old ones move
+			size_type capacity = _NextCapacity(_size + 1);
+			T * data = std::allocator<T>().allocate(capacity);
+			try
+			{
+				::new (static_cast<void *>(data + _size)) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				std::allocator<T>().deallocate(data, capacity);
+				throw;
+			}
+			_Adopt(data, capacity);
+		}
+		else
+			::new (static_cast<void *>(_data + _size)) T(std::forward<Args>(args)...);
+		return _data[_size++];
+	}
+	inline void push_back(const T & value) { emplace_back(value); }
+	inline void push_back(T && value) { emplace_back(std::move(value)); }
+
+	inline void pop_back() { _data[--_size].~T(); }
+
+	void resize(size_type size)
+	{
+		_Grow(size);
+		while (_size > size)
+			pop_back();
+		while (_size < size)
+			emplace_back();
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		iterator to = begin() + (first - cbegin());
+		iterator from = begin() + (last - cbegin());
+		iterator rtn = std::move(from, end(), to);
+		while (end() != rtn)
+			pop_back();
+		return begin() + (first - cbegin());
+	}
+	inline iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+	void clear()
+	{
+		for (size_type i = 0; i < _size; i++)
+			_data[i].~T();
+		_size = 0;
+	}
+};
+
+// Adapts SmallVector<T, N> to the template<class, class ...> class Container parameters
+template<std::size_t N>
+struct SmallVectorOf
+{
+	template<class T, class ...>
+	using Type = SmallVector<T, N>;
+};
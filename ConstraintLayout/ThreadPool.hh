@@ -0,0 +1,230 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+// Work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// while idle workers steal from the front of the others. A thread waiting
+// for tasks to finish executes queued tasks instead of blocking, so
+// ParallelFor can be nested inside a task.
+class ThreadPool
+{
+public:
+	typedef std::function<void()>	TaskType;
+	typedef std::size_t				SizeType;
+
+protected:
+	struct _Queue
+	{
+		std::mutex				mutex;
+		std::deque<TaskType>	tasks;
+	};
+
+	std::vector<std::thread>		_threads;
+	std::unique_ptr<_Queue[]>		_queues;
+	SizeType						_size;
+	std::atomic<SizeType>			_pending;
+	std::atomic<SizeType>			_queued;
+	std::atomic<SizeType>			_waiting;
+	std::atomic<SizeType>			_next;
+	std::mutex						_sleepMutex;
+	std::condition_variable			_sleep;
+	bool							_stop;
+
+	struct _Worker
+	{
+		const ThreadPool *	pool;
+		SizeType			index;
+	};
+	static inline _Worker & _Current()
+	{
+		static thread_local _Worker current = { nullptr, 0 };
+		return current;
+	}
+
+	inline SizeType _Self()
+	{
+		auto & current = _Current();
+		if (current.pool == this)
+			return current.index;
+		return _next.fetch_add(1, std::memory_order_relaxed) % _size;
+	}
+
+	inline void _Notify(bool all)
+	{
+		{ std::lock_guard<std::mutex> lock(_sleepMutex); }
+		if (all)
+			_sleep.notify_all();
+		else
+			_sleep.notify_one();
+	}
+
+	bool _TryRun(SizeType self)
+	{
+		TaskType task;
+		{
+			_Queue & own = _queues[self];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+			}
+		}
+		for (SizeType i = 1; !task && i < _size; i++)
+		{
+			_Queue & victim = _queues[(self + i) % _size];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+			}
+		}
+		if (!task)
+			return false;
+
+		_queued--;
+		task();
+		if (--_pending == 0 || _waiting > 0)
+			_Notify(true);
+		return true;
+	}
+
+	template<class Pred>
+	void _HelpUntil(Pred && done)
+	{
+		SizeType self = _Self();
+		while (!done())
+		{
+			if (_TryRun(self))
+				continue;
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_waiting++;
+			_sleep.wait(lock, [&] { return done() || _queued > 0; });
+			_waiting--;
+		}
+	}
+
+	void _Work(SizeType index)
+	{
+		_Current() = { this, index };
+		for (;;)
+		{
+			if (_TryRun(index))
+				continue;
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_sleep.wait(lock, [this] { return _stop || _queued > 0; });
+			if (_stop && _queued == 0)
+				break;
+		}
+	}
+
+public:
+	explicit ThreadPool(SizeType threads = std::thread::hardware_concurrency())
+		: _queues(new _Queue[std::max<SizeType>(threads, 1)]), _size(std::max<SizeType>(threads, 1)),
+		_pending(0), _queued(0), _waiting(0), _next(0), _stop(false)
+	{
+		for (SizeType i = 0; i < _size; i++)
+			_threads.emplace_back(&ThreadPool::_Work, this, i);
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator= (const ThreadPool &) = delete;
+
+	~ThreadPool()
+	{
+		Wait();
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+			_stop = true;
+		}
+		_sleep.notify_all();
+		for (auto & thread : _threads)
+			thread.join();
+	}
+
+	inline SizeType Size() const { return _size; }
+
+	// Index of the calling worker, or Size() for threads outside the pool
+	inline SizeType WorkerIndex() const
+	{
+		auto & current = _Current();
+		return current.pool == this ? current.index : _size;
+	}
+
+	void Submit(TaskType task)
+	{
+		_pending++;
+		{
+			_Queue & queue = _queues[_Self()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(task));
+			// Counted once stealable, so a worker woken by it finds the task
+			_queued++;
+		}
+		_Notify(false);
+	}
+
+	// Runs queued tasks on the calling thread until every submitted task finished.
+	// Must not be called from inside a task; use ParallelFor there.
+	void Wait()
+	{
+		_HelpUntil([this] { return _pending == 0; });
+	}
+
+	// Runs queued tasks on the calling thread until done() holds.
+	// Safe to call from inside a task.
+	template<class Pred>
+	inline void Wait(Pred && done)
+	{
+		_HelpUntil(std::forward<Pred>(done));
+	}
+
+	// Calls func(begin, end) on disjoint chunks of at most grain indices
+	// and returns once all of them finished
+	template<class Func>
+	void ParallelFor(SizeType begin, SizeType end, SizeType grain, Func && func)
+	{
+		if (begin >= end)
+			return;
+		if (grain == 0)
+			grain = 1;
+		SizeType chunks = (end - begin + grain - 1) / grain;
+		if (chunks == 1)
+		{
+			func(begin, end);
+			return;
+		}
+
+		std::atomic<SizeType> remaining(chunks);
+		for (SizeType i = 1; i < chunks; i++)
+		{
+			SizeType first = begin + i * grain;
+			SizeType last = std::min<SizeType>(first + grain, end);
+			Submit([&func, &remaining, first, last]
+			{
+				func(first, last);
+				remaining--;
+			});
+		}
+		func(begin, std::min<SizeType>(begin + grain, end));
+		remaining--;
+		_HelpUntil([&remaining] { return remaining == 0; });
+	}
+
+	// Splits [begin, end) into roughly one chunk per worker
+	template<class Func>
+	inline void ParallelFor(SizeType begin, SizeType end, Func && func)
+	{
+		SizeType grain = (end - begin + _size - 1) / _size;
+		ParallelFor(begin, end, grain, std::forward<Func>(func));
+	}
+};